@@ -0,0 +1,335 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using charls::color_transformation;
+using charls::interleave_mode;
+using charls::jpegls_decoder;
+using charls::jpegls_encoder;
+using charls::jpegls_error;
+using std::milli;
+using std::ostream;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace charls_benchmark {
+
+namespace {
+
+const char* to_string(const interleave_mode interleave_mode) noexcept
+{
+    switch (interleave_mode)
+    {
+    case interleave_mode::none:
+        return "none";
+    case interleave_mode::line:
+        return "line";
+    case interleave_mode::sample:
+        return "sample";
+    }
+
+    return "";
+}
+
+
+const char* to_string(const color_transformation color_transformation) noexcept
+{
+    switch (color_transformation)
+    {
+    case color_transformation::none:
+        return "none";
+    case color_transformation::hp1:
+        return "hp1";
+    case color_transformation::hp2:
+        return "hp2";
+    case color_transformation::hp3:
+        return "hp3";
+    }
+
+    return "";
+}
+
+
+template<typename Operation>
+statistics measure(const int repetitions, const size_t uncompressed_size, const size_t pixel_count, Operation operation)
+{
+    vector<double> times(static_cast<size_t>(repetitions));
+    for (auto& time : times)
+    {
+        const auto start = steady_clock::now();
+        operation();
+        time = duration<double, milli>(steady_clock::now() - start).count();
+    }
+
+    double sum{};
+    for (const auto time : times)
+    {
+        sum += time;
+    }
+    const double mean = sum / repetitions;
+
+    double square_sum{};
+    for (const auto time : times)
+    {
+        square_sum += (time - mean) * (time - mean);
+    }
+    const double standard_deviation = repetitions > 1 ? std::sqrt(square_sum / (repetitions - 1)) : 0.0;
+
+    return {mean, standard_deviation, *std::min_element(times.cbegin(), times.cend()),
+            static_cast<double>(uncompressed_size) / (mean * 1000), static_cast<double>(pixel_count) / (mean * 1000)};
+}
+
+
+// Returns an empty string when all decoded samples are within NEAR of the source samples.
+string verify(const image& source, const vector<uint8_t>& decoded, const int32_t near_lossless)
+{
+    if (decoded.size() != source.pixels.size())
+        return "decoded image has a different size";
+
+    if (near_lossless == 0)
+        return decoded == source.pixels ? string() : "decoded image is different";
+
+    if (source.info.bits_per_sample <= 8)
+    {
+        for (size_t i = 0; i < decoded.size(); ++i)
+        {
+            if (std::abs(decoded[i] - source.pixels[i]) > near_lossless)
+                return "decoded sample differs more than NEAR";
+        }
+    }
+    else
+    {
+        const auto* decoded_samples = reinterpret_cast<const uint16_t*>(decoded.data());
+        const auto* source_samples = reinterpret_cast<const uint16_t*>(source.pixels.data());
+        for (size_t i = 0; i < decoded.size() / 2; ++i)
+        {
+            if (std::abs(decoded_samples[i] - source_samples[i]) > near_lossless)
+                return "decoded sample differs more than NEAR";
+        }
+    }
+
+    return {};
+}
+
+
+void write_json_string(ostream& output, const string& value)
+{
+    output << '"';
+    for (const char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            output << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            output << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }
+        else
+        {
+            output << c;
+        }
+    }
+    output << '"';
+}
+
+
+void write_json(ostream& output, const statistics& value)
+{
+    output << "{\"mean_ms\": " << value.mean_ms << ", \"standard_deviation_ms\": " << value.standard_deviation_ms
+           << ", \"minimum_ms\": " << value.minimum_ms << ", \"megabytes_per_second\": " << value.megabytes_per_second
+           << ", \"megapixels_per_second\": " << value.megapixels_per_second << "}";
+}
+
+
+void write_text(ostream& output, const char* operation, const statistics& value)
+{
+    const double relative_deviation = value.mean_ms > 0 ? 100 * value.standard_deviation_ms / value.mean_ms : 0;
+    output << "  " << operation << std::setw(8) << value.megabytes_per_second << " MB/s" << std::setw(8)
+           << value.megapixels_per_second << " MP/s +/-" << std::setw(5) << relative_deviation << "%";
+}
+
+} // namespace
+
+
+string case_name(const image& source, const interleave_mode interleave_mode, const int32_t near_lossless,
+                 const color_transformation color_transformation)
+{
+    std::ostringstream name;
+    name << source.name << '/' << source.info.width << 'x' << source.info.height << '/' << source.info.bits_per_sample
+         << "bit/" << source.info.component_count << "c/" << to_string(interleave_mode) << "/near" << near_lossless;
+    if (color_transformation != color_transformation::none)
+    {
+        name << '/' << to_string(color_transformation);
+    }
+
+    return name.str();
+}
+
+
+benchmark_result run_case(const benchmark_case& test_case, const int repetitions)
+{
+    const image& source{*test_case.source};
+    benchmark_result result{test_case.name, source.info, test_case.interleave_mode, test_case.near_lossless,
+                            test_case.color_transformation, source.pixels.size(), 0, repetitions, {}, {}, {}};
+    const size_t pixel_count = static_cast<size_t>(source.info.width) * source.info.height;
+
+    try
+    {
+        jpegls_encoder encoder;
+        encoder.frame_info(source.info)
+            .interleave_mode(test_case.interleave_mode)
+            .near_lossless(test_case.near_lossless)
+            .color_transformation(test_case.color_transformation);
+        vector<uint8_t> encoded(encoder.estimated_destination_size());
+
+        const auto encode = [&] {
+            encoder.destination(encoded);
+            result.encoded_size = encoder.encode(source.pixels);
+            encoder.reset();
+        };
+
+        vector<uint8_t> decoded(source.pixels.size());
+        const auto decode = [&] {
+            jpegls_decoder decoder;
+            decoder.source(encoded.data(), result.encoded_size).read_header();
+            decoder.decode(decoded);
+        };
+
+        encode();
+        decode();
+        result.error = verify(source, decoded, test_case.near_lossless);
+        if (!result.error.empty())
+            return result;
+
+        result.encode = measure(repetitions, source.pixels.size(), pixel_count, encode);
+        result.decode = measure(repetitions, source.pixels.size(), pixel_count, decode);
+    }
+    catch (const jpegls_error& error)
+    {
+        result.error = error.what();
+    }
+
+    return result;
+}
+
+
+benchmark_result run_decode_case(const string& filename, const int repetitions)
+{
+    benchmark_result result{filename, {}, interleave_mode::none, 0, color_transformation::none, 0, 0, repetitions, {}, {}, {}};
+
+    std::ifstream input(filename, std::ios::in | std::ios::binary);
+    if (!input)
+    {
+        result.error = "cannot open file";
+        return result;
+    }
+    const vector<uint8_t> encoded{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+
+    try
+    {
+        jpegls_decoder decoder{encoded};
+        decoder.read_header();
+        result.info = decoder.frame_info();
+        result.interleave_mode = decoder.interleave_mode();
+        result.near_lossless = decoder.near_lossless();
+        result.encoded_size = encoded.size();
+        result.uncompressed_size = decoder.destination_size();
+
+        vector<uint8_t> decoded(result.uncompressed_size);
+        result.decode = measure(repetitions, result.uncompressed_size, static_cast<size_t>(result.info.width) * result.info.height, [&] {
+            jpegls_decoder repeated_decoder{encoded};
+            repeated_decoder.read_header();
+            repeated_decoder.decode(decoded);
+        });
+    }
+    catch (const jpegls_error& error)
+    {
+        result.error = error.what();
+    }
+
+    return result;
+}
+
+
+void write_text(ostream& output, const benchmark_result& result)
+{
+    output << std::left << std::setw(58) << result.name << std::right;
+    if (!result.error.empty())
+    {
+        output << "  FAILED: " << result.error << '\n';
+        return;
+    }
+
+    output << std::fixed << std::setprecision(1);
+    if (result.encode.mean_ms > 0)
+    {
+        write_text(output, "encode", result.encode);
+    }
+    write_text(output, "decode", result.decode);
+
+    const double bits_per_pixel = 8.0 * result.encoded_size / (static_cast<double>(result.info.width) * result.info.height);
+    output << std::setprecision(2) << "  " << bits_per_pixel << " bpp\n";
+    output << std::defaultfloat << std::setprecision(6);
+}
+
+
+void write_json(ostream& output, const vector<benchmark_result>& results)
+{
+    output << "{\n  \"charls_version\": ";
+    write_json_string(output, charls_get_version_string());
+    output << ",\n  \"cpu_dispatch_path\": ";
+    write_json_string(output, charls::cpu_dispatch_path());
+#ifdef NDEBUG
+    output << ",\n  \"debug_build\": false";
+#else
+    output << ",\n  \"debug_build\": true";
+#endif
+    output << ",\n  \"results\": [";
+
+    const char* separator = "\n";
+    for (const auto& result : results)
+    {
+        output << separator << "    {\"name\": ";
+        write_json_string(output, result.name);
+        output << ", \"width\": " << result.info.width << ", \"height\": " << result.info.height
+               << ", \"bits_per_sample\": " << result.info.bits_per_sample
+               << ", \"component_count\": " << result.info.component_count << ", \"interleave_mode\": \""
+               << to_string(result.interleave_mode) << "\", \"near_lossless\": " << result.near_lossless
+               << ", \"color_transformation\": \"" << to_string(result.color_transformation)
+               << "\", \"uncompressed_size\": " << result.uncompressed_size << ", \"encoded_size\": " << result.encoded_size
+               << ", \"repetitions\": " << result.repetitions;
+        if (result.error.empty())
+        {
+            if (result.encode.mean_ms > 0)
+            {
+                output << ", \"encode\": ";
+                write_json(output, result.encode);
+            }
+            output << ", \"decode\": ";
+            write_json(output, result.decode);
+        }
+        else
+        {
+            output << ", \"error\": ";
+            write_json_string(output, result.error);
+        }
+        output << "}";
+        separator = ",\n";
+    }
+
+    output << "\n  ]\n}\n";
+}
+
+} // namespace charls_benchmark
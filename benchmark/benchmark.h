@@ -0,0 +1,67 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "images.h"
+
+#include <charls/charls.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace charls_benchmark {
+
+// The statistics of the repeated measurements of one operation.
+struct statistics final
+{
+    double mean_ms;
+    double standard_deviation_ms;
+    double minimum_ms;
+    double megabytes_per_second;  // uncompressed bytes, based on the mean time.
+    double megapixels_per_second; // based on the mean time.
+};
+
+
+// Purpose: one entry of the parameter matrix, the source image and the coding parameters.
+struct benchmark_case final
+{
+    std::string name;
+    const image* source;
+    charls::interleave_mode interleave_mode;
+    int32_t near_lossless;
+    charls::color_transformation color_transformation;
+};
+
+
+struct benchmark_result final
+{
+    std::string name;
+    charls::frame_info info;
+    charls::interleave_mode interleave_mode;
+    int32_t near_lossless;
+    charls::color_transformation color_transformation;
+    size_t uncompressed_size;
+    size_t encoded_size;
+    int repetitions;
+    statistics encode;
+    statistics decode;
+    std::string error; // empty when encoding, decoding and the verification of the decoded image succeeded.
+};
+
+
+// Returns a descriptive name of the case, used to select cases with a filter and to track a case between runs.
+std::string case_name(const image& source, charls::interleave_mode interleave_mode, int32_t near_lossless,
+                      charls::color_transformation color_transformation);
+
+// Encodes and decodes the source image once to warm up and verify the result, then measures both operations.
+benchmark_result run_case(const benchmark_case& test_case, int repetitions);
+
+// Decodes an existing JPEG-LS file (encode statistics are not available).
+benchmark_result run_decode_case(const std::string& filename, int repetitions);
+
+void write_text(std::ostream& output, const benchmark_result& result);
+void write_json(std::ostream& output, const std::vector<benchmark_result>& results);
+
+} // namespace charls_benchmark
@@ -0,0 +1,176 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "images.h"
+
+#include "../test/portable_anymap_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using charls::frame_info;
+using std::ifstream;
+using std::string;
+using std::vector;
+
+namespace charls_benchmark {
+
+namespace {
+
+size_t bytes_per_sample(const frame_info& info) noexcept
+{
+    return info.bits_per_sample > 8 ? 2 : 1;
+}
+
+
+bool is_machine_little_endian() noexcept
+{
+    const uint16_t value{1};
+    uint8_t first_byte;
+    memcpy(&first_byte, &value, 1);
+    return first_byte == 1;
+}
+
+
+// Returns the index of a sample in the planar or pixel interleaved order.
+size_t sample_index(const frame_info& info, const bool planar, const size_t pixel, const int32_t component) noexcept
+{
+    return planar ? static_cast<size_t>(component) * info.width * info.height + pixel
+                  : pixel * info.component_count + component;
+}
+
+
+struct bundled_image final
+{
+    const char* filename;
+    long offset; // negative: the pixels are stored at the end of the file.
+    uint32_t width;
+    uint32_t height;
+    int32_t bits_per_sample;
+    int32_t component_count;
+    bool little_endian;
+};
+
+
+// The images used by the performance tests of the CharLS test application.
+constexpr bundled_image bundled_images[]{
+    {"alphatest.raw", 0, 380, 287, 8, 4, false},
+    {"MR2_UNC", 1728, 1024, 1024, 16, 1, true},
+    {"0015.raw", 0, 1024, 1024, 8, 1, false},
+    {"lena8b.raw", 0, 512, 512, 8, 1, false},
+    {"desktop.ppm", 40, 1280, 1024, 8, 3, false},
+    {"SIEMENS-MR-RGB-16Bits.dcm", -1, 192, 256, 12, 3, true},
+    {"DSC_5455.raw", 142949, 300, 200, 16, 3, true}};
+
+
+bool read_file(const string& filename, const long offset, vector<uint8_t>& buffer)
+{
+    ifstream input(filename, std::ios::in | std::ios::binary);
+    if (!input)
+        return false;
+
+    input.seekg(0, std::ios::end);
+    const auto file_size = static_cast<long>(input.tellg());
+    const long start = offset < 0 ? file_size - static_cast<long>(buffer.size()) : offset;
+    if (start < 0 || start + static_cast<long>(buffer.size()) > file_size)
+        return false;
+
+    input.seekg(start, std::ios::beg);
+    input.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    return static_cast<bool>(input);
+}
+
+} // namespace
+
+
+image create_synthetic_image(const charls_imagegen::image_family family, const uint32_t width, const uint32_t height,
+                             const int32_t bits_per_sample, const int32_t component_count, const bool planar)
+{
+    return {string("synthetic/") + to_string(family),
+            {width, height, bits_per_sample, component_count},
+            planar,
+            charls_imagegen::generate_image({family, width, height, bits_per_sample, component_count, planar, 1})};
+}
+
+
+image convert_layout(const image& source, const bool planar)
+{
+    if (source.planar == planar || source.info.component_count == 1)
+    {
+        image result{source};
+        result.planar = planar;
+        return result;
+    }
+
+    image result{source.name, source.info, planar, vector<uint8_t>(source.pixels.size())};
+    const size_t sample_size = bytes_per_sample(source.info);
+    const size_t pixel_count = static_cast<size_t>(source.info.width) * source.info.height;
+    for (size_t pixel = 0; pixel < pixel_count; ++pixel)
+    {
+        for (int32_t component = 0; component < source.info.component_count; ++component)
+        {
+            std::copy_n(&source.pixels[sample_index(source.info, source.planar, pixel, component) * sample_size], sample_size,
+                        &result.pixels[sample_index(result.info, planar, pixel, component) * sample_size]);
+        }
+    }
+
+    return result;
+}
+
+
+vector<image> read_bundled_images(const string& directory)
+{
+    vector<image> images;
+    for (const auto& bundled : bundled_images)
+    {
+        image result{string("bundled/") + bundled.filename,
+                     {bundled.width, bundled.height, bundled.bits_per_sample, bundled.component_count}, false, {}};
+        result.pixels.resize(static_cast<size_t>(bundled.width) * bundled.height * bundled.component_count *
+                             bytes_per_sample(result.info));
+        if (!read_file(directory + "/" + bundled.filename, bundled.offset, result.pixels))
+            continue;
+
+        if (result.info.bits_per_sample > 8 && bundled.little_endian != is_machine_little_endian())
+        {
+            for (size_t i = 0; i < result.pixels.size(); i += 2)
+            {
+                std::swap(result.pixels[i], result.pixels[i + 1]);
+            }
+        }
+
+        // The 16 bit RGB photo is also used as 12 bit image (as was done by the performance test).
+        if (result.info.bits_per_sample == 16 && result.info.component_count == 3)
+        {
+            image image12{result};
+            image12.name += "/12bit";
+            image12.info.bits_per_sample = 12;
+            for (size_t i = 0; i < image12.pixels.size(); i += 2)
+            {
+                uint16_t value;
+                memcpy(&value, &image12.pixels[i], sizeof value);
+                value = static_cast<uint16_t>(value >> 4);
+                memcpy(&image12.pixels[i], &value, sizeof value);
+            }
+            images.push_back(image12);
+        }
+
+        images.push_back(std::move(result));
+    }
+
+    return images;
+}
+
+
+image read_anymap_image(const string& filename)
+{
+    charls_test::portable_anymap_file anymap_file(filename.c_str());
+
+    return {filename,
+            {static_cast<uint32_t>(anymap_file.width()), static_cast<uint32_t>(anymap_file.height()),
+             anymap_file.bits_per_sample(), anymap_file.component_count()},
+            false,
+            std::move(anymap_file.image_data())};
+}
+
+} // namespace charls_benchmark
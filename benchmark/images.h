@@ -0,0 +1,40 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "../imagegen/synthetic_image.h"
+
+#include <charls/charls.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace charls_benchmark {
+
+// Purpose: an uncompressed image. Samples larger than 8 bits are stored as 16 bit values (machine byte order),
+// the pixels are stored planar (interleave mode none) or with the components of a pixel after each other.
+struct image final
+{
+    std::string name;
+    charls::frame_info info;
+    bool planar;
+    std::vector<uint8_t> pixels;
+};
+
+
+// Creates a synthetic image of the image generator, the same parameters always create the same image.
+image create_synthetic_image(charls_imagegen::image_family family, uint32_t width, uint32_t height, int32_t bits_per_sample,
+                             int32_t component_count, bool planar);
+
+// Stores the pixels of an image in the requested (planar or pixel interleaved) order.
+image convert_layout(const image& source, bool planar);
+
+// Reads the images that are bundled with the CharLS test application, missing images are skipped.
+std::vector<image> read_bundled_images(const std::string& directory);
+
+// Reads an image stored in the Portable Anymap Format (PGM or PPM).
+image read_anymap_image(const std::string& filename);
+
+} // namespace charls_benchmark
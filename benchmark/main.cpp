@@ -0,0 +1,393 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "benchmark.h"
+#include "images.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using charls::color_transformation;
+using charls::interleave_mode;
+using charls::jpegls_decoder;
+using charls::jpegls_encoder;
+using charls_benchmark::benchmark_case;
+using charls_benchmark::benchmark_result;
+using charls_benchmark::create_synthetic_image;
+using charls_benchmark::image;
+using charls_imagegen::image_family;
+using std::cout;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace {
+
+#ifndef CHARLS_BENCHMARK_IMAGE_DIRECTORY
+#define CHARLS_BENCHMARK_IMAGE_DIRECTORY "test"
+#endif
+
+struct options final
+{
+    int repetitions{5};
+    vector<uint32_t> sizes;
+    string filter;
+    string image_directory{CHARLS_BENCHMARK_IMAGE_DIRECTORY};
+    vector<string> images;
+    vector<string> decode_files;
+    string json_filename;
+    bool list{};
+    bool startup{};
+};
+
+
+// The coding parameters that are measured for one source image.
+struct coding_parameters final
+{
+    charls::interleave_mode interleave_mode;
+    int32_t near_lossless;
+    charls::color_transformation color_transformation;
+};
+
+
+// An image of the parameter matrix and the coding parameters it is measured with.
+struct matrix_entry final
+{
+    image_family family;
+    int32_t bits_per_sample;
+    int32_t component_count;
+    bool planar;
+    vector<coding_parameters> parameters;
+};
+
+
+void print_usage()
+{
+    cout << "CharLS benchmark: measures encoding and decoding of synthetic and bundled images.\n"
+            "Options:\n"
+            "  -quick              only the small synthetic images and 3 repetitions\n"
+            "  -repetitions:N      number of measurements of every operation (default 5)\n"
+            "  -size:N             width and height of the synthetic images, can be repeated (default 256 and 1024)\n"
+            "  -filter:TEXT        only run the cases with TEXT in their name\n"
+            "  -imagedir:DIR       directory with the bundled test images (default " CHARLS_BENCHMARK_IMAGE_DIRECTORY ")\n"
+            "  -image:FILE         also measure a PGM or PPM image, can be repeated\n"
+            "  -decode:FILE        measure the decoding of a JPEG-LS file, can be repeated\n"
+            "  -json:FILE          write the results in the JSON format (for regression tracking)\n"
+            "  -list               print the names of the cases without running them\n"
+            "  -startup            measure the cost of the first operations in a process (run it as the only option)\n";
+}
+
+
+bool parse_options(const int argc, const char* const argv[], options& result)
+{
+    bool quick{};
+    for (int i = 1; i < argc; ++i)
+    {
+        const string option{argv[i]};
+        const auto separator = option.find(':');
+        const string name{option.substr(0, separator)};
+        const string value{separator == string::npos ? string() : option.substr(separator + 1)};
+
+        if (name == "-quick")
+        {
+            quick = true;
+        }
+        else if (name == "-repetitions" && !value.empty())
+        {
+            result.repetitions = std::atoi(value.c_str());
+            if (result.repetitions < 1)
+                return false;
+        }
+        else if (name == "-size" && !value.empty())
+        {
+            const int size = std::atoi(value.c_str());
+            if (size < 16)
+                return false;
+            result.sizes.push_back(static_cast<uint32_t>(size));
+        }
+        else if (name == "-filter")
+        {
+            result.filter = value;
+        }
+        else if (name == "-imagedir" && !value.empty())
+        {
+            result.image_directory = value;
+        }
+        else if (name == "-image" && !value.empty())
+        {
+            result.images.push_back(value);
+        }
+        else if (name == "-decode" && !value.empty())
+        {
+            result.decode_files.push_back(value);
+        }
+        else if (name == "-json" && !value.empty())
+        {
+            result.json_filename = value;
+        }
+        else if (name == "-list")
+        {
+            result.list = true;
+        }
+        else if (name == "-startup")
+        {
+            result.startup = true;
+        }
+        else
+        {
+            cout << "Option not understood: " << option << "\n";
+            return false;
+        }
+    }
+
+    if (result.sizes.empty())
+    {
+        result.sizes.push_back(256);
+        if (!quick)
+        {
+            result.sizes.push_back(1024);
+        }
+    }
+
+    if (quick && result.repetitions == options{}.repetitions)
+    {
+        result.repetitions = 3;
+    }
+
+    return true;
+}
+
+
+// The parameter matrix: all bit depths and component layouts with smooth images (lossless and near-lossless),
+// the color transformations, and the other image families for the layouts that are common for their content.
+vector<matrix_entry> create_matrix()
+{
+    vector<matrix_entry> matrix;
+    for (const int32_t bits_per_sample : {8, 10, 12, 16})
+    {
+        matrix.push_back({image_family::smooth, bits_per_sample, 1, true,
+                          {{interleave_mode::none, 0, color_transformation::none}, {interleave_mode::none, 2, color_transformation::none}}});
+        matrix.push_back({image_family::smooth, bits_per_sample, 3, true,
+                          {{interleave_mode::none, 0, color_transformation::none}, {interleave_mode::none, 2, color_transformation::none}}});
+        matrix_entry interleaved{image_family::smooth, bits_per_sample, 3, false,
+                                 {{interleave_mode::line, 0, color_transformation::none},
+                                  {interleave_mode::line, 2, color_transformation::none},
+                                  {interleave_mode::sample, 0, color_transformation::none},
+                                  {interleave_mode::sample, 2, color_transformation::none}}};
+
+        // The color transformations are only lossless for 8 and 16 bit samples.
+        if (bits_per_sample == 8 || bits_per_sample == 16)
+        {
+            for (const auto transformation : {color_transformation::hp1, color_transformation::hp2, color_transformation::hp3})
+            {
+                interleaved.parameters.push_back({interleave_mode::sample, 0, transformation});
+            }
+        }
+        matrix.push_back(std::move(interleaved));
+        matrix.push_back({image_family::smooth, bits_per_sample, 4, false,
+                          {{interleave_mode::sample, 0, color_transformation::none}, {interleave_mode::sample, 2, color_transformation::none}}});
+
+        matrix.push_back({image_family::medical, bits_per_sample, 1, true,
+                          {{interleave_mode::none, 0, color_transformation::none}, {interleave_mode::none, 2, color_transformation::none}}});
+        matrix.push_back({image_family::screen, bits_per_sample, 3, false, {{interleave_mode::sample, 0, color_transformation::none}}});
+        for (const auto family : {image_family::noise, image_family::runs})
+        {
+            matrix.push_back({family, bits_per_sample, 1, true, {{interleave_mode::none, 0, color_transformation::none}}});
+            matrix.push_back({family, bits_per_sample, 3, false, {{interleave_mode::sample, 0, color_transformation::none}}});
+        }
+    }
+
+    return matrix;
+}
+
+
+// Bundled and user supplied images are measured lossless and near-lossless with their own layout.
+vector<coding_parameters> image_parameters(const image& source)
+{
+    const interleave_mode mode = source.info.component_count == 1 ? interleave_mode::none : interleave_mode::sample;
+    return {{mode, 0, color_transformation::none}, {mode, 2, color_transformation::none}};
+}
+
+
+class benchmark_runner final
+{
+public:
+    explicit benchmark_runner(const options& options) :
+        options_{options}
+    {
+    }
+
+    // Runs the cases of the source image that match the filter, the image is only created when needed.
+    template<typename CreateImage>
+    void run(const image& header, const vector<coding_parameters>& parameters, CreateImage create_image)
+    {
+        vector<benchmark_case> cases;
+        for (const auto& parameter : parameters)
+        {
+            string name{charls_benchmark::case_name(header, parameter.interleave_mode, parameter.near_lossless, parameter.color_transformation)};
+            if (name.find(options_.filter) == string::npos)
+                continue;
+
+            if (options_.list)
+            {
+                cout << name << "\n";
+                continue;
+            }
+
+            cases.push_back({std::move(name), nullptr, parameter.interleave_mode, parameter.near_lossless, parameter.color_transformation});
+        }
+
+        if (cases.empty())
+            return;
+
+        const image source{create_image()};
+        for (auto& test_case : cases)
+        {
+            test_case.source = &source;
+            add_result(run_case(test_case, options_.repetitions));
+        }
+    }
+
+    void add_result(benchmark_result result)
+    {
+        write_text(cout, result);
+        failed_ |= !result.error.empty();
+        results_.push_back(std::move(result));
+    }
+
+    const vector<benchmark_result>& results() const noexcept
+    {
+        return results_;
+    }
+
+    bool failed() const noexcept
+    {
+        return failed_;
+    }
+
+private:
+    const options& options_;
+    vector<benchmark_result> results_;
+    bool failed_{};
+};
+
+
+// Measures the cost of the first operations in a process, the lookup tables are created on first use.
+void measure_startup()
+{
+    const image source16{create_synthetic_image(image_family::noise, 64, 64, 16, 1, true)};
+    const vector<uint8_t> source8(static_cast<size_t>(64) * 64, 128);
+    const auto encoded16 = jpegls_encoder::encode(source16.pixels, source16.info);
+    const auto encoded8 = jpegls_encoder::encode(source8, {64, 64, 8, 1});
+
+    const auto measure = [](const char* name, const vector<uint8_t>& encoded, const bool decode) {
+        vector<uint8_t> destination;
+        const auto start = steady_clock::now();
+        jpegls_decoder decoder{encoded};
+        decoder.read_header();
+        if (decode)
+        {
+            destination.resize(decoder.destination_size());
+            decoder.decode(destination);
+        }
+        cout << name << ": " << duration<double, std::micro>(steady_clock::now() - start).count() << " us\n";
+    };
+
+    measure("First read header", encoded16, false);
+    measure("First decode 16 bit", encoded16, true);
+    measure("Second decode 16 bit", encoded16, true);
+    measure("First decode 8 bit", encoded8, true);
+    measure("Second decode 8 bit", encoded8, true);
+}
+
+} // namespace
+
+
+int main(const int argc, const char* const argv[])
+{
+    options options;
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    if (options.startup)
+    {
+        measure_startup();
+        return EXIT_SUCCESS;
+    }
+
+#ifndef NDEBUG
+    cout << "NOTE: running the benchmark with a debug build, performance may be slow!\n";
+#endif
+    if (!options.list)
+    {
+        cout << "CharLS " << charls_get_version_string() << ", CPU dispatch path " << charls::cpu_dispatch_path()
+             << ", " << options.repetitions << " repetitions\n";
+    }
+
+    benchmark_runner runner{options};
+
+    for (const uint32_t size : options.sizes)
+    {
+        for (const auto& entry : create_matrix())
+        {
+            const image header{string("synthetic/") + to_string(entry.family),
+                               {size, size, entry.bits_per_sample, entry.component_count}, entry.planar, {}};
+            runner.run(header, entry.parameters, [&] {
+                return create_synthetic_image(entry.family, size, size, entry.bits_per_sample, entry.component_count, entry.planar);
+            });
+        }
+    }
+
+    for (auto& source : charls_benchmark::read_bundled_images(options.image_directory))
+    {
+        runner.run(source, image_parameters(source), [&] { return std::move(source); });
+    }
+
+    for (const auto& filename : options.images)
+    {
+        try
+        {
+            image source{charls_benchmark::read_anymap_image(filename)};
+            runner.run(source, image_parameters(source), [&] { return std::move(source); });
+        }
+        catch (const std::ios_base::failure&)
+        {
+            runner.add_result({filename, {}, interleave_mode::none, 0, color_transformation::none, 0, 0, 0, {}, {}, "cannot read image"});
+        }
+    }
+
+    for (const auto& filename : options.decode_files)
+    {
+        if (filename.find(options.filter) == string::npos)
+            continue;
+
+        if (options.list)
+        {
+            cout << filename << "\n";
+            continue;
+        }
+
+        runner.add_result(charls_benchmark::run_decode_case(filename, options.repetitions));
+    }
+
+    if (!options.json_filename.empty())
+    {
+        std::ofstream json_file(options.json_filename);
+        write_json(json_file, runner.results());
+        if (!json_file)
+        {
+            cout << "Failed to write " << options.json_filename << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    return runner.failed() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -133,6 +133,11 @@ public enum JpegLSError
         /// </summary>
         MissingEndOfSpiffDirectory = 24,
 
+        /// <summary>
+        /// This error is returned when a restart marker is not found, or found out of sequence, at the end of a restart interval.
+        /// </summary>
+        RestartMarkerNotFound = 25,
+
         /// <summary>
         /// The argument for the width parameter is outside the range [1, 65535].
         /// </summary>
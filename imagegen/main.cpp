@@ -0,0 +1,258 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "synthetic_image.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using charls_imagegen::image_family;
+using charls_imagegen::image_parameters;
+using std::cout;
+using std::string;
+using std::vector;
+
+namespace {
+
+struct options final
+{
+    vector<image_family> families;
+    image_parameters parameters{image_family::smooth, 512, 512, 8, 1, false, 1};
+    string output;
+    string corpus_directory;
+};
+
+
+void print_usage()
+{
+    cout << "CharLS image generator: creates deterministic synthetic images for testing and benchmarking.\n"
+            "Options:\n"
+            "  -family:NAME        smooth, medical, screen, noise or runs (default smooth), can be repeated with -corpus\n"
+            "  -width:N            width of the image (default 512)\n"
+            "  -height:N           height of the image (default 512)\n"
+            "  -size:N             width and height of the image\n"
+            "  -bits:N             bits per sample, 2 - 16 (default 8)\n"
+            "  -components:N       number of components, 1 - 255 (default 1)\n"
+            "  -planar             store the components after each other (raw files only)\n"
+            "  -seed:N             seed of the random number generator (default 1)\n"
+            "  -output:FILE        write the image: .pgm and .ppm files are written as Portable Anymap, other files as\n"
+            "                      raw samples (16 bit samples in the byte order of the machine)\n"
+            "  -corpus:DIR         write an image of every selected family (default all) to DIR\n";
+}
+
+
+bool parse_number(const string& value, const uint32_t minimum, uint32_t& result)
+{
+    char* end;
+    const unsigned long number = std::strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || number < minimum || number > UINT32_MAX)
+        return false;
+
+    result = static_cast<uint32_t>(number);
+    return true;
+}
+
+
+bool parse_options(const int argc, const char* const argv[], options& result)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const string option{argv[i]};
+        const auto separator = option.find(':');
+        const string name{option.substr(0, separator)};
+        const string value{separator == string::npos ? string() : option.substr(separator + 1)};
+
+        uint32_t number{};
+        if (name == "-family")
+        {
+            image_family family;
+            if (!try_parse(value, family))
+                return false;
+            result.families.push_back(family);
+        }
+        else if (name == "-width" && parse_number(value, 1, number))
+        {
+            result.parameters.width = number;
+        }
+        else if (name == "-height" && parse_number(value, 1, number))
+        {
+            result.parameters.height = number;
+        }
+        else if (name == "-size" && parse_number(value, 1, number))
+        {
+            result.parameters.width = number;
+            result.parameters.height = number;
+        }
+        else if (name == "-bits" && parse_number(value, 2, number))
+        {
+            result.parameters.bits_per_sample = static_cast<int32_t>(std::min(number, 17U));
+        }
+        else if (name == "-components" && parse_number(value, 1, number))
+        {
+            result.parameters.component_count = static_cast<int32_t>(std::min(number, 256U));
+        }
+        else if (name == "-planar")
+        {
+            result.parameters.planar = true;
+        }
+        else if (name == "-seed" && parse_number(value, 0, number))
+        {
+            result.parameters.seed = number;
+        }
+        else if (name == "-output" && !value.empty())
+        {
+            result.output = value;
+        }
+        else if (name == "-corpus" && !value.empty())
+        {
+            result.corpus_directory = value;
+        }
+        else
+        {
+            cout << "Option not understood: " << option << "\n";
+            return false;
+        }
+    }
+
+    return result.output.empty() != result.corpus_directory.empty();
+}
+
+
+bool is_anymap_filename(const string& filename)
+{
+    const auto extension_start = filename.rfind('.');
+    if (extension_start == string::npos)
+        return false;
+
+    const string extension{filename.substr(extension_start)};
+    return extension == ".pgm" || extension == ".ppm" || extension == ".pnm";
+}
+
+
+// Writes a PGM or PPM file, the Portable Anymap format stores 16 bit samples big endian.
+void write_anymap_file(const string& filename, const image_parameters& parameters, const vector<uint8_t>& pixels)
+{
+    if (parameters.component_count != 1 && parameters.component_count != 3)
+        throw std::invalid_argument("Portable Anymap files need 1 or 3 components");
+
+    if (parameters.planar)
+        throw std::invalid_argument("Portable Anymap files cannot store planar images");
+
+    std::ofstream output(filename, std::ios::out | std::ios::binary);
+    output << (parameters.component_count == 1 ? "P5" : "P6") << '\n'
+           << parameters.width << ' ' << parameters.height << '\n'
+           << (1 << parameters.bits_per_sample) - 1 << '\n';
+
+    if (parameters.bits_per_sample <= 8)
+    {
+        output.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    }
+    else
+    {
+        vector<uint8_t> big_endian(pixels.size());
+        for (size_t i = 0; i < pixels.size(); i += 2)
+        {
+            uint16_t sample;
+            memcpy(&sample, &pixels[i], sizeof sample);
+            big_endian[i] = static_cast<uint8_t>(sample >> 8);
+            big_endian[i + 1] = static_cast<uint8_t>(sample);
+        }
+        output.write(reinterpret_cast<const char*>(big_endian.data()), static_cast<std::streamsize>(big_endian.size()));
+    }
+
+    if (!output)
+        throw std::runtime_error("Failed to write " + filename);
+}
+
+
+void write_raw_file(const string& filename, const vector<uint8_t>& pixels)
+{
+    std::ofstream output(filename, std::ios::out | std::ios::binary);
+    output.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    if (!output)
+        throw std::runtime_error("Failed to write " + filename);
+}
+
+
+void write_image(const string& filename, const image_parameters& parameters)
+{
+    const vector<uint8_t> pixels{generate_image(parameters)};
+    if (is_anymap_filename(filename))
+    {
+        write_anymap_file(filename, parameters, pixels);
+    }
+    else
+    {
+        write_raw_file(filename, pixels);
+    }
+
+    cout << filename << '\n';
+}
+
+
+// The name of a corpus file describes the image, PGM and PPM files are used when the format can store the image.
+string corpus_filename(const options& options, const image_parameters& parameters)
+{
+    string filename{options.corpus_directory + '/' + to_string(parameters.family) + '_' + std::to_string(parameters.width) +
+                    'x' + std::to_string(parameters.height) + '_' + std::to_string(parameters.bits_per_sample) + "bit_" +
+                    std::to_string(parameters.component_count) + 'c'};
+
+    if (!parameters.planar && parameters.component_count == 1)
+        return filename + ".pgm";
+
+    if (!parameters.planar && parameters.component_count == 3)
+        return filename + ".ppm";
+
+    return filename + (parameters.planar ? "_planar.raw" : ".raw");
+}
+
+} // namespace
+
+
+int main(const int argc, const char* const argv[])
+{
+    options options;
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        if (options.corpus_directory.empty())
+        {
+            image_parameters parameters{options.parameters};
+            parameters.family = options.families.empty() ? image_family::smooth : options.families.front();
+            write_image(options.output, parameters);
+        }
+        else
+        {
+            if (options.families.empty())
+            {
+                options.families.assign(std::begin(charls_imagegen::image_families), std::end(charls_imagegen::image_families));
+            }
+
+            for (const auto family : options.families)
+            {
+                image_parameters parameters{options.parameters};
+                parameters.family = family;
+                write_image(corpus_filename(options, parameters), parameters);
+            }
+        }
+    }
+    catch (const std::exception& error)
+    {
+        cout << error.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,424 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "synthetic_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using std::string;
+using std::vector;
+
+namespace charls_imagegen {
+
+namespace {
+
+// Purpose: a small pseudo random number generator (SplitMix64) with a specified output for every seed.
+class random_generator final
+{
+public:
+    explicit random_generator(const uint32_t seed) noexcept :
+        state_{seed}
+    {
+    }
+
+    uint32_t next() noexcept
+    {
+        state_ += 0x9E3779B97F4A7C15;
+        uint64_t z = state_;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+        return static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+    }
+
+    // Returns a value in the range [low, high].
+    int32_t uniform(const int32_t low, const int32_t high) noexcept
+    {
+        return low + static_cast<int32_t>(next() % (static_cast<uint32_t>(high - low) + 1));
+    }
+
+    // Returns a value in the range [-amplitude, amplitude], values near 0 are more likely (like sensor noise).
+    int32_t noise(const int32_t amplitude) noexcept
+    {
+        const int32_t first = uniform(-amplitude, amplitude);
+        return (first + uniform(-amplitude, amplitude)) / 2;
+    }
+
+private:
+    uint64_t state_;
+};
+
+
+int32_t clamp(const int64_t value, const int32_t maximum_value) noexcept
+{
+    return static_cast<int32_t>(std::min(std::max(value, int64_t{}), static_cast<int64_t>(maximum_value)));
+}
+
+
+// The samples of the image, with the components of a pixel after each other.
+class sample_buffer final
+{
+public:
+    explicit sample_buffer(const image_parameters& parameters) :
+        width_{parameters.width},
+        component_count_{parameters.component_count},
+        samples_(static_cast<size_t>(parameters.width) * parameters.height * parameters.component_count)
+    {
+    }
+
+    int32_t& operator()(const uint32_t x, const uint32_t y, const int32_t component) noexcept
+    {
+        return samples_[(static_cast<size_t>(y) * width_ + x) * component_count_ + component];
+    }
+
+    const vector<int32_t>& samples() const noexcept
+    {
+        return samples_;
+    }
+
+private:
+    uint32_t width_;
+    int32_t component_count_;
+    vector<int32_t> samples_;
+};
+
+
+// Gradients that run diagonally over the image, shifted for every component, with a little noise.
+void generate_smooth(const image_parameters& parameters, random_generator& random, sample_buffer& samples)
+{
+    const int32_t maximum_value = (1 << parameters.bits_per_sample) - 1;
+    const int32_t noise_amplitude = 1 << std::max(parameters.bits_per_sample - 6, 0);
+    const int64_t diagonal = static_cast<int64_t>(parameters.width) + parameters.height;
+
+    for (uint32_t y = 0; y < parameters.height; ++y)
+    {
+        for (uint32_t x = 0; x < parameters.width; ++x)
+        {
+            for (int32_t component = 0; component < parameters.component_count; ++component)
+            {
+                const int64_t gradient = (x + y + static_cast<int64_t>(component) * (parameters.width / 4)) * maximum_value / diagonal;
+                samples(x, y, component) = clamp(gradient + random.uniform(-noise_amplitude, noise_amplitude), maximum_value);
+            }
+        }
+    }
+}
+
+
+// Purpose: an ellipse, the coordinates are scaled to make the test exact with integer arithmetic.
+struct ellipse final
+{
+    int64_t center_x;
+    int64_t center_y;
+    int64_t radius_x;
+    int64_t radius_y;
+
+    bool contains(const int64_t x, const int64_t y) const noexcept
+    {
+        constexpr int64_t scale{1024};
+        const int64_t dx = (x - center_x) * scale / radius_x;
+        const int64_t dy = (y - center_y) * scale / radius_y;
+        return dx * dx + dy * dy <= scale * scale;
+    }
+};
+
+
+// A body on a flat background of zero: the body has regions with their own intensity and noise.
+void generate_medical(const image_parameters& parameters, random_generator& random, sample_buffer& samples)
+{
+    const int32_t maximum_value = (1 << parameters.bits_per_sample) - 1;
+    const int32_t noise_amplitude = 1 << std::max(parameters.bits_per_sample - 5, 0);
+    const int64_t width = parameters.width;
+    const int64_t height = parameters.height;
+    const ellipse body{width / 2, height / 2, std::max(width * 9 / 20, int64_t{1}), std::max(height * 9 / 20, int64_t{1})};
+
+    struct region final
+    {
+        ellipse shape;
+        int32_t level;
+    };
+    vector<region> regions(8);
+    for (auto& region : regions)
+    {
+        region.shape = {body.center_x + random.uniform(-static_cast<int32_t>(width / 4), static_cast<int32_t>(width / 4)),
+                        body.center_y + random.uniform(-static_cast<int32_t>(height / 4), static_cast<int32_t>(height / 4)),
+                        std::max(width * random.uniform(4, 15) / 100, int64_t{1}),
+                        std::max(height * random.uniform(4, 15) / 100, int64_t{1})};
+        region.level = random.uniform(maximum_value / 8, maximum_value * 7 / 8);
+    }
+
+    for (uint32_t y = 0; y < parameters.height; ++y)
+    {
+        for (uint32_t x = 0; x < parameters.width; ++x)
+        {
+            if (!body.contains(x, y))
+            {
+                for (int32_t component = 0; component < parameters.component_count; ++component)
+                {
+                    samples(x, y, component) = 0;
+                }
+                continue;
+            }
+
+            // The last region that contains the pixel is on top, the tissue without a region has a vertical gradient.
+            int64_t level = maximum_value / 3 + (maximum_value / 8) * (y - body.center_y) / body.radius_y;
+            for (const auto& region : regions)
+            {
+                if (region.shape.contains(x, y))
+                {
+                    level = region.level;
+                }
+            }
+
+            for (int32_t component = 0; component < parameters.component_count; ++component)
+            {
+                samples(x, y, component) = clamp(level - level * component / 8 + random.noise(noise_amplitude), maximum_value);
+            }
+        }
+    }
+}
+
+
+// Windows with a border, a title bar and lines of text on a flat desktop background, in a few colors.
+void generate_screen(const image_parameters& parameters, random_generator& random, sample_buffer& samples)
+{
+    constexpr int32_t glyph_width{6};
+    constexpr int32_t glyph_height{8};
+    constexpr int32_t line_height{12};
+    constexpr int32_t title_height{14};
+
+    enum color : uint8_t
+    {
+        desktop,
+        window,
+        border,
+        title,
+        text,
+        title_text,
+        color_count
+    };
+
+    // The font: every glyph has a 5 x 7 pattern, the remaining column and line are the spacing.
+    vector<uint64_t> font(64);
+    for (auto& glyph : font)
+    {
+        glyph = static_cast<uint64_t>(random.next()) << 3;
+        glyph |= random.next() >> 29;
+    }
+
+    const uint32_t width = parameters.width;
+    const uint32_t height = parameters.height;
+    vector<uint8_t> canvas(static_cast<size_t>(width) * height, desktop);
+    const auto draw_text = [&](const uint32_t left, const uint32_t top, const uint32_t right, const uint32_t bottom, const color foreground) {
+        uint32_t x = left;
+        while (x + glyph_width <= right)
+        {
+            const int32_t length = random.uniform(-4, 10); // negative: the spacing between words.
+            for (int32_t character = 0; character < std::abs(length) && x + glyph_width <= right; ++character, x += glyph_width)
+            {
+                if (length < 0)
+                    continue;
+
+                const uint64_t glyph = font[static_cast<size_t>(random.uniform(0, 63))];
+                for (int32_t row = 0; row < glyph_height - 1 && top + row < bottom; ++row)
+                {
+                    for (int32_t column = 0; column < glyph_width - 1; ++column)
+                    {
+                        if (glyph >> (row * (glyph_width - 1) + column) & 1)
+                        {
+                            canvas[static_cast<size_t>(top + row) * width + x + column] = foreground;
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    const uint32_t window_count = std::max(static_cast<uint32_t>(static_cast<uint64_t>(width) * height / (160 * 160)), 1U);
+    for (uint32_t i = 0; i < window_count; ++i)
+    {
+        const uint32_t window_width = std::max(static_cast<uint32_t>(random.uniform(static_cast<int32_t>(width / 8), static_cast<int32_t>(width / 2))), 1U);
+        const uint32_t window_height = std::max(static_cast<uint32_t>(random.uniform(static_cast<int32_t>(height / 8), static_cast<int32_t>(height / 2))), 1U);
+        const uint32_t left = static_cast<uint32_t>(random.uniform(0, static_cast<int32_t>(width - window_width)));
+        const uint32_t top = static_cast<uint32_t>(random.uniform(0, static_cast<int32_t>(height - window_height)));
+
+        for (uint32_t y = top; y < top + window_height; ++y)
+        {
+            for (uint32_t x = left; x < left + window_width; ++x)
+            {
+                const bool is_border = x == left || x == left + window_width - 1 || y == top || y == top + window_height - 1;
+                canvas[static_cast<size_t>(y) * width + x] = is_border ? border : y < top + title_height ? title : window;
+            }
+        }
+
+        if (window_width < 2 * glyph_width || window_height < title_height + line_height)
+            continue;
+
+        draw_text(left + 4, top + 3, left + window_width / 2, top + title_height, title_text);
+        for (uint32_t y = top + title_height + 4; y + glyph_height < top + window_height; y += line_height)
+        {
+            draw_text(left + 4, y, left + window_width - 4, top + window_height - 1, text);
+        }
+    }
+
+    vector<int32_t> palette(static_cast<size_t>(color_count) * parameters.component_count);
+    const int32_t maximum_value = (1 << parameters.bits_per_sample) - 1;
+    for (auto& value : palette)
+    {
+        value = random.uniform(0, maximum_value);
+    }
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const size_t color_index = canvas[static_cast<size_t>(y) * width + x];
+            for (int32_t component = 0; component < parameters.component_count; ++component)
+            {
+                samples(x, y, component) = palette[color_index * parameters.component_count + component];
+            }
+        }
+    }
+}
+
+
+void generate_noise(const image_parameters& parameters, random_generator& random, sample_buffer& samples)
+{
+    const int32_t maximum_value = (1 << parameters.bits_per_sample) - 1;
+    for (uint32_t y = 0; y < parameters.height; ++y)
+    {
+        for (uint32_t x = 0; x < parameters.width; ++x)
+        {
+            for (int32_t component = 0; component < parameters.component_count; ++component)
+            {
+                samples(x, y, component) = random.uniform(0, maximum_value);
+            }
+        }
+    }
+}
+
+
+// Horizontal runs of 8 to 256 pixels with a constant color that repeat for a band of 16 lines.
+void generate_runs(const image_parameters& parameters, random_generator& random, sample_buffer& samples)
+{
+    const int32_t maximum_value = (1 << parameters.bits_per_sample) - 1;
+    for (uint32_t top = 0; top < parameters.height; top += 16)
+    {
+        const uint32_t bottom = std::min(top + 16, parameters.height);
+        for (uint32_t x = 0; x < parameters.width;)
+        {
+            const uint32_t end = std::min(x + static_cast<uint32_t>(random.uniform(8, 256)), parameters.width);
+            for (int32_t component = 0; component < parameters.component_count; ++component)
+            {
+                const int32_t value = random.uniform(0, maximum_value);
+                for (uint32_t y = top; y < bottom; ++y)
+                {
+                    for (uint32_t i = x; i < end; ++i)
+                    {
+                        samples(i, y, component) = value;
+                    }
+                }
+            }
+            x = end;
+        }
+    }
+}
+
+} // namespace
+
+
+const char* to_string(const image_family family) noexcept
+{
+    switch (family)
+    {
+    case image_family::smooth:
+        return "smooth";
+    case image_family::medical:
+        return "medical";
+    case image_family::screen:
+        return "screen";
+    case image_family::noise:
+        return "noise";
+    case image_family::runs:
+        return "runs";
+    }
+
+    return "";
+}
+
+
+bool try_parse(const string& name, image_family& family) noexcept
+{
+    for (const auto candidate : image_families)
+    {
+        if (name == to_string(candidate))
+        {
+            family = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+vector<uint8_t> generate_image(const image_parameters& parameters)
+{
+    if (parameters.width == 0 || parameters.height == 0)
+        throw std::invalid_argument("width and height must be at least 1");
+
+    if (parameters.bits_per_sample < 2 || parameters.bits_per_sample > 16)
+        throw std::invalid_argument("bits per sample must be in the range [2, 16]");
+
+    if (parameters.component_count < 1 || parameters.component_count > 255)
+        throw std::invalid_argument("component count must be in the range [1, 255]");
+
+    random_generator random{parameters.seed};
+    sample_buffer samples{parameters};
+    switch (parameters.family)
+    {
+    case image_family::smooth:
+        generate_smooth(parameters, random, samples);
+        break;
+    case image_family::medical:
+        generate_medical(parameters, random, samples);
+        break;
+    case image_family::screen:
+        generate_screen(parameters, random, samples);
+        break;
+    case image_family::noise:
+        generate_noise(parameters, random, samples);
+        break;
+    case image_family::runs:
+        generate_runs(parameters, random, samples);
+        break;
+    default:
+        throw std::invalid_argument("unknown image family");
+    }
+
+    const size_t sample_size = parameters.bits_per_sample > 8 ? 2 : 1;
+    const size_t pixel_count = static_cast<size_t>(parameters.width) * parameters.height;
+    const auto component_count = static_cast<size_t>(parameters.component_count);
+    vector<uint8_t> pixels(samples.samples().size() * sample_size);
+    for (size_t pixel = 0; pixel < pixel_count; ++pixel)
+    {
+        for (size_t component = 0; component < component_count; ++component)
+        {
+            const int32_t value = samples.samples()[pixel * component_count + component];
+            const size_t index = parameters.planar ? component * pixel_count + pixel : pixel * component_count + component;
+            if (sample_size == 1)
+            {
+                pixels[index] = static_cast<uint8_t>(value);
+            }
+            else
+            {
+                const auto sample = static_cast<uint16_t>(value);
+                memcpy(&pixels[index * 2], &sample, sizeof sample);
+            }
+        }
+    }
+
+    return pixels;
+}
+
+} // namespace charls_imagegen
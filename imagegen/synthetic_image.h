@@ -0,0 +1,49 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace charls_imagegen {
+
+// The image families: every family exercises other coding paths of a JPEG-LS codec.
+enum class image_family
+{
+    smooth,  // gradients with a little noise: short Golomb codes in regular mode.
+    medical, // noisy tissue on a flat (zero) background, like CT and MR images: run mode and long Golomb codes.
+    screen,  // windows, text and a few colors, like screen captures: mostly run mode with sharp edges.
+    noise,   // uniform random samples over the full range: worst case compression.
+    runs     // horizontal runs of a constant value that repeat for bands of lines: run mode and run interruptions.
+};
+
+constexpr image_family image_families[]{image_family::smooth, image_family::medical, image_family::screen,
+                                        image_family::noise, image_family::runs};
+
+const char* to_string(image_family family) noexcept;
+
+// Returns true and sets family when name is the name of an image family.
+bool try_parse(const std::string& name, image_family& family) noexcept;
+
+
+struct image_parameters final
+{
+    image_family family;
+    uint32_t width;
+    uint32_t height;
+    int32_t bits_per_sample; // [2, 16]
+    int32_t component_count; // [1, 255]
+    bool planar;             // true: the components are stored after each other, false: the components of a pixel are stored together.
+    uint32_t seed;
+};
+
+
+// Generates the pixels of a synthetic image. Samples of 8 bits or less are stored as bytes, larger samples as
+// 16 bit values in the byte order of the machine. The generator doesn't depend on the random number distributions
+// of the standard library: the same parameters create the same image with every compiler and on every platform.
+/// <exception cref="std::invalid_argument">Thrown when a parameter is out of range.</exception>
+std::vector<uint8_t> generate_image(const image_parameters& parameters);
+
+} // namespace charls_imagegen
@@ -9,7 +9,9 @@
 #ifdef __cplusplus
 
 #include <memory>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 #else
 
@@ -23,6 +25,7 @@
 
 struct charls_jpegls_decoder;
 struct charls_jpegls_encoder;
+struct charls_jpegls_batch;
 
 extern "C" {
 
@@ -30,6 +33,7 @@ extern "C" {
 
 typedef struct charls_jpegls_decoder charls_jpegls_decoder;
 typedef struct charls_jpegls_encoder charls_jpegls_encoder;
+typedef struct charls_jpegls_batch charls_jpegls_batch;
 
 #endif
 
@@ -61,6 +65,30 @@ charls_jpegls_decoder_destroy(const charls_jpegls_decoder* decoder) CHARLS_NOEXC
 CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_decoder_set_source_buffer(charls_jpegls_decoder* decoder, const void* source_buffer, size_t source_size_bytes) CHARLS_NOEXCEPT;
 
+/// <summary>
+/// Set the reference to a partial source buffer that contains the first part of the encoded JPEG-LS byte stream data.
+/// When the decoder needs data beyond the end of the partial source buffer, the functions return CHARLS_JPEGLS_ERRC_NEED_MORE_DATA.
+/// The operation can be continued by calling the same function again, after more data has been passed with
+/// charls_jpegls_decoder_extend_source_buffer. Decoding continues at the start of the line it could not complete.
+/// </summary>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="source_buffer">Reference to the start of the partial source buffer.</param>
+/// <param name="source_size_bytes">Size in bytes of the data that is available in the source buffer.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_partial_source_buffer(charls_jpegls_decoder* decoder, const void* source_buffer, size_t source_size_bytes) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Passes the next received part of the JPEG-LS byte stream to a decoder that was started with charls_jpegls_decoder_set_partial_source_buffer.
+/// The buffer must start with all the data that was passed before: it may be a different (reallocated) buffer.
+/// </summary>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="source_buffer">Reference to the start of the source buffer.</param>
+/// <param name="source_size_bytes">Size in bytes of the data that is available in the source buffer.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_extend_source_buffer(charls_jpegls_decoder* decoder, const void* source_buffer, size_t source_size_bytes) CHARLS_NOEXCEPT;
+
 /// <summary>
 /// Tries to read the SPIFF header from the source buffer.
 /// If a SPIFF header exists its content will be put into the spiff_header parameter and header_found will be set to 1.
@@ -131,6 +159,64 @@ charls_jpegls_decoder_get_interleave_mode(const charls_jpegls_decoder* decoder,
 CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_decoder_get_preset_coding_parameters(const charls_jpegls_decoder* decoder, int32_t reserved, charls_jpegls_pc_parameters* preset_coding_parameters) CHARLS_NOEXCEPT;
 
+/// <summary>
+/// Builds an index with the decoding state at every row_interval rows, to decode regions of interest faster.
+/// </summary>
+/// <remarks>
+/// Function should be called after calling the function charls_jpegls_decoder_read_header.
+/// The index is built by decoding the complete image once, after that the decoder is ready to decode the frame again.
+/// A region of interest is then decoded from the last indexed row before the region instead of from the first row.
+/// The index is kept by charls_jpegls_decoder_rewind, setting a source buffer removes the index.
+/// Every indexed row uses the memory of about one decoded row and 6 KiB for the coding contexts.
+/// </remarks>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="row_interval">The number of rows between two indexed rows, must be larger than 0.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_build_row_index(charls_jpegls_decoder* decoder, uint32_t row_interval) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Restricts the decoding to a rectangular region of interest of the frame.
+/// </summary>
+/// <remarks>
+/// Function should be called after calling the function charls_jpegls_decoder_read_header.
+/// The decoding stops after the last line of the region, the lines below it are not decoded.
+/// The destination size and the computed stride are based on the width and height of the region.
+/// </remarks>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="region">The region of interest, must be inside the frame.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_region(charls_jpegls_decoder* decoder, const charls_rect* region) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Decodes a reduced resolution preview instead of the full resolution frame.
+/// </summary>
+/// <remarks>
+/// Function should be called after calling the function charls_jpegls_decoder_read_header (and after setting a region).
+/// The frame is decoded at full fidelity and every block of scale_factor x scale_factor pixels is averaged while the rows
+/// are decoded: no full resolution buffer is needed. The destination size and the computed stride are based on the
+/// size of the preview. A preview cannot be combined with a partial source or with charls_jpegls_decoder_decode_to_callback.
+/// </remarks>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="options">The scale factor and the optional window to map the samples to 8 bits.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_preview(charls_jpegls_decoder* decoder, const charls_preview_options* options) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Configures if the decoder uses multiple threads. The default is false.
+/// </summary>
+/// <remarks>
+/// The component scans of an image with interleave mode none and the restart intervals of a scan are then decoded in
+/// parallel when possible. The worker threads are started for each decode operation.
+/// </remarks>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="parallel_decoding">True to decode the component scans and restart intervals in parallel.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_parallel_decoding(charls_jpegls_decoder* decoder, bool parallel_decoding) CHARLS_NOEXCEPT;
+
 /// <summary>
 /// Returns the size required for the destination buffer in bytes to hold the decoded pixel data.
 /// </summary>
@@ -149,6 +235,7 @@ charls_jpegls_decoder_get_destination_size(const charls_jpegls_decoder* decoder,
 /// </summary>
 /// <remarks>
 /// Function should be called after calling the function charls_jpegls_decoder_read_header.
+/// When a partial source runs out of data, the function must be called again with the same destination to continue.
 /// </remarks>
 /// <param name="decoder">Reference to the decoder instance.</param>
 /// <param name="destination_buffer">Byte array that holds the encoded bytes when the function returns.</param>
@@ -158,6 +245,72 @@ charls_jpegls_decoder_get_destination_size(const charls_jpegls_decoder* decoder,
 CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_decoder_decode_to_buffer(const charls_jpegls_decoder* decoder, void* destination_buffer, size_t destination_size_bytes, uint32_t stride) CHARLS_NOEXCEPT;
 
+/// <summary>
+/// Will decode the JPEG-LS byte stream from the source buffer and pass the decoded rows of pixels, a strip at a time, to a callback.
+/// Only the strip needs to be kept in memory, which makes it possible to process images that are larger than the available memory.
+/// </summary>
+/// <remarks>
+/// Function should be called after calling the function charls_jpegls_decoder_read_header.
+/// In interleave mode none all rows of the first component are passed first, followed by the rows of the next component.
+/// When a partial source runs out of data the completed rows are passed first, continuing uses the strip and callback of the first call.
+/// </remarks>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="strip">Byte array that is used to pass the decoded rows, its size determines how many rows are passed at a time.</param>
+/// <param name="strip_size">Length of the array in bytes. If the array cannot hold a single row, the function will return an error.</param>
+/// <param name="callback">Function that is called for every completed strip of rows.</param>
+/// <param name="user_context">User context that is passed to the callback.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_decode_to_callback(charls_jpegls_decoder* decoder, void* strip, size_t strip_size,
+                                         charls_decode_rows_callback callback, void* user_context) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Resets the decoder to the state before a source was set, to allow the decoding of the next JPEG-LS byte stream.
+/// The internal resources are kept, which makes decoding a series of images with the same parameters faster
+/// than creating a new decoder for every image.
+/// </summary>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_reset(charls_jpegls_decoder* decoder) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Rewinds the decoder to the start of the current source buffer, to decode the same frame (or another region of it) again.
+/// </summary>
+/// <remarks>
+/// Function should be called after calling the function charls_jpegls_decoder_read_header, it reads the header again.
+/// The row index built by charls_jpegls_decoder_build_row_index is kept: the source buffer must not have been modified.
+/// A partial source buffer cannot be rewound.
+/// </remarks>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_rewind(charls_jpegls_decoder* decoder) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Sets the callback that receives the stages of the decoding process: reading the header, creating a codec,
+/// decoding a scan, transforming a decoded line and passing the last rows to the destination.
+/// </summary>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="callback">The callback function, a null pointer disables tracing.</param>
+/// <param name="user_context">Pointer that is passed to the callback.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_trace_callback(charls_jpegls_decoder* decoder, charls_trace_callback callback, void* user_context) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Returns the counters of the coding events of all frames decoded since the decoder was created or reset.
+/// </summary>
+/// <remarks>
+/// The counters are only collected when CharLS has been built with the CMake option CHARLS_ENABLE_STATISTICS,
+/// otherwise the function returns statistics_not_enabled.
+/// </remarks>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="statistics">Reference to the structure that will hold the counters.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_get_statistics(const charls_jpegls_decoder* decoder, charls_coding_statistics* statistics) CHARLS_NOEXCEPT;
+
 
 /// <summary>
 /// Creates a JPEG-LS encoder instance, when finished with the instance destroy it with the function charls_jpegls_encoder_destroy.
@@ -224,6 +377,30 @@ charls_jpegls_encoder_set_preset_coding_parameters(charls_jpegls_encoder* encode
 CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_set_color_transformation(charls_jpegls_encoder* encoder, charls_color_transformation color_transformation) CHARLS_NOEXCEPT;
 
+/// <summary>
+/// Configures the restart interval the encoder should use. The default is 0, which means no restart markers.
+/// When set, a DRI segment is written and the bit stream of every scan is split in intervals of the given number
+/// of lines, separated by RSTm markers. Restart intervals can be decoded independently (and in parallel).
+/// </summary>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="restart_interval">The number of lines between 2 restart markers [0, 65535].</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_restart_interval(charls_jpegls_encoder* encoder, uint32_t restart_interval) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Configures if the component scans of an image with interleave mode none are encoded in parallel. The default is false.
+/// </summary>
+/// <remarks>
+/// Every scan is then encoded on its own worker thread into a private buffer, these threads are started for each
+/// encode operation. The scans are written in order when all are done.
+/// </remarks>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="parallel_components">True to encode the component scans in parallel.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_parallel_components(charls_jpegls_encoder* encoder, bool parallel_components) CHARLS_NOEXCEPT;
+
 /// <summary>
 /// Returns the size in bytes, that the encoder expects are needed to hold the encoded image.
 /// </summary>
@@ -301,6 +478,23 @@ charls_jpegls_encoder_write_spiff_entry(charls_jpegls_encoder* encoder, uint32_t
 CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_encode_from_buffer(charls_jpegls_encoder* encoder, const void* source_buffer, size_t source_size, uint32_t stride) CHARLS_NOEXCEPT;
 
+/// <summary>
+/// Encodes the image data to the destination, the rows of pixels are requested from a callback, a strip at a time.
+/// Only the strip needs to be kept in memory, which makes it possible to encode rows as they arrive from an image source.
+/// </summary>
+/// <remarks>
+/// In interleave mode none all rows of the first component are requested first, followed by the rows of the next component.
+/// </remarks>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="strip">Byte array that is used to request the rows, its size determines how many rows are requested at a time.</param>
+/// <param name="strip_size">Length of the array in bytes. If the array cannot hold a single row, the function will return an error.</param>
+/// <param name="callback">Function that is called to fill the strip with the next rows.</param>
+/// <param name="user_context">User context that is passed to the callback.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_encode_from_callback(charls_jpegls_encoder* encoder, void* strip, size_t strip_size,
+                                           charls_encode_rows_callback callback, void* user_context) CHARLS_NOEXCEPT;
+
 /// <summary>
 /// Returns the size in bytes, that are written to the destination.
 /// </summary>
@@ -310,6 +504,85 @@ charls_jpegls_encoder_encode_from_buffer(charls_jpegls_encoder* encoder, const v
 CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_get_bytes_written(const charls_jpegls_encoder* encoder, size_t* bytes_written) CHARLS_NOEXCEPT;
 
+/// <summary>
+/// Resets the encoder to the state before a destination was set, to allow the encoding of the next frame.
+/// The configured parameters (frame info, NEAR, interleave mode, etc.) and the internal resources are kept,
+/// which makes encoding a series of frames with the same parameters faster than creating a new encoder for every frame.
+/// </summary>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_reset(charls_jpegls_encoder* encoder) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Sets the callback that receives the stages of the encoding process: creating a codec, encoding a scan,
+/// transforming a source line and flushing the coded bits of a scan.
+/// </summary>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="callback">The callback function, a null pointer disables tracing.</param>
+/// <param name="user_context">Pointer that is passed to the callback.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_trace_callback(charls_jpegls_encoder* encoder, charls_trace_callback callback, void* user_context) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Returns the counters of the coding events of all frames encoded since the encoder was created or reset.
+/// </summary>
+/// <remarks>
+/// The counters are only collected when CharLS has been built with the CMake option CHARLS_ENABLE_STATISTICS,
+/// otherwise the function returns statistics_not_enabled.
+/// </remarks>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="statistics">Reference to the structure that will hold the counters.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_get_statistics(const charls_jpegls_encoder* encoder, charls_coding_statistics* statistics) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Creates a JPEG-LS batch instance, when finished with the instance destroy it with the function charls_jpegls_batch_destroy.
+/// A batch instance owns a pool of worker threads that encode or decode multiple independent frames in parallel.
+/// </summary>
+/// <param name="thread_count">The number of worker threads, 0 means one thread for every hardware thread.</param>
+/// <returns>A reference to a new created batch instance, or a null pointer when the creation fails.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_batch* CHARLS_API_CALLING_CONVENTION
+charls_jpegls_batch_create(uint32_t thread_count) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Destroys a JPEG-LS batch instance created with charls_jpegls_batch_create, stops the worker threads and releases all internal resources attached to it.
+/// </summary>
+/// <param name="batch">Instance to destroy. If a null pointer is passed as argument, no action occurs.</param>
+CHARLS_API_IMPORT_EXPORT void CHARLS_API_CALLING_CONVENTION
+charls_jpegls_batch_destroy(const charls_jpegls_batch* batch) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Encodes all passed frames, using all worker threads of the batch. The function returns when all frames are processed.
+/// The result and the number of bytes written of every frame are stored in the frame itself.
+/// </summary>
+/// <param name="batch">Reference to the batch instance.</param>
+/// <param name="frames">Array with the frames that need to be encoded.</param>
+/// <param name="frame_count">Number of frames in the array.</param>
+/// <returns>The result of the operation: success (also when individual frames failed) or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_batch_encode(charls_jpegls_batch* batch, charls_batch_encode_frame* frames, size_t frame_count) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Decodes all passed frames, using all worker threads of the batch. The function returns when all frames are processed.
+/// The result of every frame is stored in the frame itself.
+/// </summary>
+/// <param name="batch">Reference to the batch instance.</param>
+/// <param name="frames">Array with the frames that need to be decoded.</param>
+/// <param name="frame_count">Number of frames in the array.</param>
+/// <returns>The result of the operation: success (also when individual frames failed) or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_batch_decode(charls_jpegls_batch* batch, charls_batch_decode_frame* frames, size_t frame_count) CHARLS_NOEXCEPT;
+
+/// <summary>
+/// Returns the name of the CPU specific code path that is used by the encoder and decoder: "generic", "sse2", "avx2" or "avx512bw".
+/// The code path is selected once, based on the instruction sets that are supported by the CPU that runs the library.
+/// </summary>
+CHARLS_API_IMPORT_EXPORT const char* CHARLS_API_CALLING_CONVENTION
+charls_get_cpu_dispatch_path(void) CHARLS_NOEXCEPT;
+
 
 // Note: The 4 methods below are considered obsolete and will be removed in the next major update.
 
@@ -382,6 +655,90 @@ CHARLS_API_IMPORT_EXPORT CharlsApiResultType CHARLS_API_CALLING_CONVENTION JpegL
 
 namespace charls {
 
+/// <summary>
+/// Returns the name of the CPU specific code path that is used by the encoder and decoder: "generic", "sse2", "avx2" or "avx512bw".
+/// </summary>
+inline const char* cpu_dispatch_path() noexcept
+{
+    return charls_get_cpu_dispatch_path();
+}
+
+/// <summary>
+/// Trace callback implementation that keeps the last spans in a fixed size ring buffer.
+/// Pass the buffer to the trace function of an encoder or decoder, the buffer must remain valid while it is used.
+/// </summary>
+class trace_ring_buffer final
+{
+public:
+    /// <summary>
+    /// Constructs a trace_ring_buffer instance.
+    /// </summary>
+    /// <param name="capacity">The maximum number of stored spans, when the buffer is full the oldest span is overwritten.</param>
+    explicit trace_ring_buffer(const size_t capacity) :
+        spans_(capacity)
+    {
+    }
+
+    /// <summary>
+    /// Returns the stored spans in the order they were reported, the oldest span first.
+    /// </summary>
+    CHARLS_NO_DISCARD std::vector<trace_span> spans() const
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        const size_t count = span_count_ < spans_.size() ? span_count_ : spans_.size();
+
+        std::vector<trace_span> result;
+        result.reserve(count);
+        for (size_t i = span_count_ - count; i < span_count_; ++i)
+        {
+            result.push_back(spans_[i % spans_.size()]);
+        }
+
+        return result;
+    }
+
+    /// <summary>
+    /// Returns the number of spans reported since the buffer was created or cleared, including the overwritten spans.
+    /// </summary>
+    CHARLS_NO_DISCARD size_t span_count() const
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        return span_count_;
+    }
+
+    /// <summary>
+    /// Removes all stored spans.
+    /// </summary>
+    void clear()
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        span_count_ = 0;
+    }
+
+    /// <summary>
+    /// The trace callback function, the user context is the trace_ring_buffer instance.
+    /// </summary>
+    static void CHARLS_API_CALLING_CONVENTION callback(const trace_span* span, void* user_context) noexcept
+    {
+        static_cast<trace_ring_buffer*>(user_context)->add(*span);
+    }
+
+private:
+    void add(const trace_span& span) noexcept
+    {
+        if (spans_.empty())
+            return;
+
+        const std::lock_guard<std::mutex> lock(mutex_);
+        spans_[span_count_ % spans_.size()] = span;
+        ++span_count_;
+    }
+
+    mutable std::mutex mutex_;
+    std::vector<trace_span> spans_;
+    size_t span_count_{};
+};
+
 /// <summary>
 /// JPEG-LS decoder class that encapsulates the C ABI interface calls and provide a native C++ interface.
 /// </summary>
@@ -455,6 +812,30 @@ class jpegls_decoder final
         return source(source_container.data(), source_container.size() * sizeof(ValueType));
     }
 
+    /// <summary>
+    /// Set the reference to a partial source buffer that contains the first part of the encoded JPEG-LS byte stream data.
+    /// When more data is needed, read_header and decode report jpegls_errc::need_more_data: call extend_source
+    /// when more data has been received and call the same function again to continue.
+    /// </summary>
+    /// <param name="source_buffer">Reference to the start of the partial source buffer.</param>
+    /// <param name="source_size_bytes">Size in bytes of the data that is available in the source buffer.</param>
+    jpegls_decoder& partial_source(const void* source_buffer, const size_t source_size_bytes)
+    {
+        check_jpegls_errc(charls_jpegls_decoder_set_partial_source_buffer(decoder_.get(), source_buffer, source_size_bytes));
+        return *this;
+    }
+
+    /// <summary>
+    /// Passes the next received part of a partial source, the buffer must start with all the data that was passed before.
+    /// </summary>
+    /// <param name="source_buffer">Reference to the start of the source buffer, may be different from the previous buffer.</param>
+    /// <param name="source_size_bytes">Size in bytes of the data that is available in the source buffer.</param>
+    jpegls_decoder& extend_source(const void* source_buffer, const size_t source_size_bytes)
+    {
+        check_jpegls_errc(charls_jpegls_decoder_extend_source_buffer(decoder_.get(), source_buffer, source_size_bytes));
+        return *this;
+    }
+
     /// <summary>
     /// Tries to read the SPIFF header from the JPEG-LS stream.
     /// If a SPIFF header exists its will be returned otherwise the struct will be filled with default values.
@@ -556,6 +937,53 @@ class jpegls_decoder final
         return preset_coding_parameters;
     }
 
+    /// <summary>
+    /// Builds an index with the decoding state at every row_interval rows, to decode regions of interest faster.
+    /// Function should be called after read_header. The index is kept by rewind(), setting a source removes the index.
+    /// </summary>
+    /// <param name="row_interval">The number of rows between two indexed rows, must be larger than 0.</param>
+    /// <returns>Reference to this instance.</returns>
+    jpegls_decoder& build_row_index(const uint32_t row_interval)
+    {
+        check_jpegls_errc(charls_jpegls_decoder_build_row_index(decoder_.get(), row_interval));
+        return *this;
+    }
+
+    /// <summary>
+    /// Restricts the decoding to a rectangular region of interest of the frame.
+    /// Function should be called after read_header.
+    /// </summary>
+    /// <param name="region">The region of interest, must be inside the frame.</param>
+    /// <returns>Reference to this instance.</returns>
+    jpegls_decoder& region(const charls_rect& region)
+    {
+        check_jpegls_errc(charls_jpegls_decoder_set_region(decoder_.get(), &region));
+        return *this;
+    }
+
+    /// <summary>
+    /// Decodes a reduced resolution preview instead of the full resolution frame.
+    /// Function should be called after read_header (and after region).
+    /// </summary>
+    /// <param name="options">The scale factor and the optional window to map the samples to 8 bits.</param>
+    /// <returns>Reference to this instance.</returns>
+    jpegls_decoder& preview(const preview_options& options)
+    {
+        check_jpegls_errc(charls_jpegls_decoder_set_preview(decoder_.get(), &options));
+        return *this;
+    }
+
+    /// <summary>
+    /// Configures if the component scans and the restart intervals are decoded in parallel. The default is false.
+    /// </summary>
+    /// <param name="parallel_decoding">True to decode the component scans and restart intervals in parallel.</param>
+    /// <returns>Reference to this instance.</returns>
+    jpegls_decoder& parallel_decoding(const bool parallel_decoding)
+    {
+        check_jpegls_errc(charls_jpegls_decoder_set_parallel_decoding(decoder_.get(), parallel_decoding));
+        return *this;
+    }
+
     /// <summary>
     /// Returns the size required for the destination buffer in bytes to hold the decoded pixel data.
     /// Function can be read_header.
@@ -580,6 +1008,18 @@ class jpegls_decoder final
         check_jpegls_errc(charls_jpegls_decoder_decode_to_buffer(decoder_.get(), destination_buffer, destination_size_bytes, stride));
     }
 
+    /// <summary>
+    /// Will decode the JPEG-LS byte stream set with source into the destination buffer.
+    /// </summary>
+    /// <param name="destination_buffer">Byte array that holds the encoded bytes when the function returns.</param>
+    /// <param name="destination_size_bytes">Length of the array in bytes. If the array is too small the function will return an error.</param>
+    /// <param name="stride">Number of bytes to the next line in the buffer, when zero, decoder will compute it.</param>
+    /// <param name="ec">The out-parameter for error reporting, jpegls_errc::need_more_data when a partial source ran out of data.</param>
+    void decode(void* destination_buffer, const size_t destination_size_bytes, const uint32_t stride, std::error_code& ec) const noexcept
+    {
+        ec = charls_jpegls_decoder_decode_to_buffer(decoder_.get(), destination_buffer, destination_size_bytes, stride);
+    }
+
     /// <summary>
     /// Will decode the JPEG-LS byte stream set with source into the destination container.
     /// </summary>
@@ -605,6 +1045,84 @@ class jpegls_decoder final
         return destination;
     }
 
+    /// <summary>
+    /// Will decode the JPEG-LS byte stream set with source and pass the decoded rows, a strip at a time, to a callback.
+    /// </summary>
+    /// <param name="strip">Byte array that is used to pass the decoded rows, its size determines how many rows are passed at a time.</param>
+    /// <param name="strip_size">Length of the array in bytes.</param>
+    /// <param name="callback">Function that is called for every completed strip, a nonzero return value aborts decoding.</param>
+    /// <param name="user_context">User context that is passed to the callback.</param>
+    void decode(void* strip, const size_t strip_size, const decode_rows_callback callback, void* user_context) const
+    {
+        check_jpegls_errc(charls_jpegls_decoder_decode_to_callback(decoder_.get(), strip, strip_size, callback, user_context));
+    }
+
+    /// <summary>
+    /// Will decode the JPEG-LS byte stream set with source and pass the decoded rows, a strip at a time, to a function object.
+    /// </summary>
+    /// <param name="strip">Byte array that is used to pass the decoded rows, its size determines how many rows are passed at a time.</param>
+    /// <param name="strip_size">Length of the array in bytes.</param>
+    /// <param name="row_handler">Function object with the signature void(const void* rows, uint32_t row_count).</param>
+    template<typename RowHandler>
+    void decode_rows(void* strip, const size_t strip_size, RowHandler& row_handler) const
+    {
+        decode(strip, strip_size, &call_row_handler<RowHandler>, &row_handler);
+    }
+
+    /// <summary>
+    /// Resets the decoder to allow the decoding of the next JPEG-LS byte stream, the internal resources are kept.
+    /// Call source to set the next JPEG-LS byte stream afterwards.
+    /// </summary>
+    jpegls_decoder& reset()
+    {
+        check_jpegls_errc(charls_jpegls_decoder_reset(decoder_.get()));
+        return *this;
+    }
+
+    /// <summary>
+    /// Rewinds the decoder to the start of the current source and reads the header again, to decode the same frame
+    /// (or another region of it) again. The row index is kept: the source must not have been modified.
+    /// </summary>
+    jpegls_decoder& rewind()
+    {
+        check_jpegls_errc(charls_jpegls_decoder_rewind(decoder_.get()));
+        return *this;
+    }
+
+    /// <summary>
+    /// Sets the callback that receives the stages of the decoding process, a null pointer disables tracing.
+    /// </summary>
+    /// <param name="callback">The callback function, it can be called concurrently from multiple threads.</param>
+    /// <param name="user_context">Pointer that is passed to the callback.</param>
+    /// <returns>Reference to this instance.</returns>
+    jpegls_decoder& trace(const trace_callback callback, void* user_context = nullptr)
+    {
+        check_jpegls_errc(charls_jpegls_decoder_set_trace_callback(decoder_.get(), callback, user_context));
+        return *this;
+    }
+
+    /// <summary>
+    /// Stores the stages of the decoding process in a ring buffer, which must remain valid while the decoder uses it.
+    /// </summary>
+    /// <param name="buffer">The ring buffer that receives the spans.</param>
+    /// <returns>Reference to this instance.</returns>
+    jpegls_decoder& trace(trace_ring_buffer& buffer)
+    {
+        return trace(&trace_ring_buffer::callback, &buffer);
+    }
+
+    /// <summary>
+    /// Returns the counters of the coding events of all frames decoded since the decoder was created or reset.
+    /// Requires a CharLS build with the CMake option CHARLS_ENABLE_STATISTICS, otherwise statistics_not_enabled is thrown.
+    /// </summary>
+    /// <returns>The coding statistics.</returns>
+    CHARLS_NO_DISCARD coding_statistics statistics() const
+    {
+        coding_statistics statistics;
+        check_jpegls_errc(charls_jpegls_decoder_get_statistics(decoder_.get(), &statistics));
+        return statistics;
+    }
+
 private:
     CHARLS_NO_DISCARD static charls_jpegls_decoder* create_decoder()
     {
@@ -620,6 +1138,20 @@ class jpegls_decoder final
         charls_jpegls_decoder_destroy(decoder);
     }
 
+    template<typename RowHandler>
+    static int32_t CHARLS_API_CALLING_CONVENTION call_row_handler(const void* rows, const uint32_t row_count, void* user_context) noexcept
+    {
+        try
+        {
+            (*static_cast<RowHandler*>(user_context))(rows, row_count);
+            return 0;
+        }
+        catch (...)
+        {
+            return 1;
+        }
+    }
+
     std::unique_ptr<charls_jpegls_decoder, void (*)(const charls_jpegls_decoder*)> decoder_{create_decoder(), destroy_decoder};
 };
 
@@ -718,6 +1250,27 @@ class jpegls_encoder final
         return *this;
     }
 
+    /// <summary>
+    /// Configures the restart interval the encoder should use. The default is 0, which means no restart markers.
+    /// Restart intervals can be decoded independently (and in parallel).
+    /// </summary>
+    /// <param name="restart_interval">The number of lines between 2 restart markers [0, 65535].</param>
+    jpegls_encoder& restart_interval(const uint32_t restart_interval)
+    {
+        check_jpegls_errc(charls_jpegls_encoder_set_restart_interval(encoder_.get(), restart_interval));
+        return *this;
+    }
+
+    /// <summary>
+    /// Configures if the component scans of an image with interleave mode none are encoded in parallel. The default is false.
+    /// </summary>
+    /// <param name="parallel_components">True to encode the component scans in parallel.</param>
+    jpegls_encoder& parallel_components(const bool parallel_components)
+    {
+        check_jpegls_errc(charls_jpegls_encoder_set_parallel_components(encoder_.get(), parallel_components));
+        return *this;
+    }
+
     /// <summary>
     /// Returns the size in bytes, that the encoder expects are needed to hold the encoded image.
     /// </summary>
@@ -825,6 +1378,33 @@ class jpegls_encoder final
         return encode(source_container.data(), source_container.size() * sizeof(ValueType), stride);
     }
 
+    /// <summary>
+    /// Encodes the image data to the destination, the rows are requested from a callback, a strip at a time.
+    /// </summary>
+    /// <param name="strip">Byte array that is used to request the rows, its size determines how many rows are requested at a time.</param>
+    /// <param name="strip_size">Length of the array in bytes.</param>
+    /// <param name="callback">Function that is called to fill the strip with the next rows, a nonzero return value aborts encoding.</param>
+    /// <param name="user_context">User context that is passed to the callback.</param>
+    /// <returns>The number of bytes written to the destination.</returns>
+    size_t encode(void* strip, const size_t strip_size, const encode_rows_callback callback, void* user_context) const
+    {
+        check_jpegls_errc(charls_jpegls_encoder_encode_from_callback(encoder_.get(), strip, strip_size, callback, user_context));
+        return bytes_written();
+    }
+
+    /// <summary>
+    /// Encodes the image data to the destination, the rows are requested from a function object, a strip at a time.
+    /// </summary>
+    /// <param name="strip">Byte array that is used to request the rows, its size determines how many rows are requested at a time.</param>
+    /// <param name="strip_size">Length of the array in bytes.</param>
+    /// <param name="row_source">Function object with the signature void(void* rows, uint32_t row_count) that fills the rows.</param>
+    /// <returns>The number of bytes written to the destination.</returns>
+    template<typename RowSource>
+    size_t encode_rows(void* strip, const size_t strip_size, RowSource& row_source) const
+    {
+        return encode(strip, strip_size, &call_row_source<RowSource>, &row_source);
+    }
+
     /// <summary>
     /// Returns the size in bytes, that are written to the destination.
     /// </summary>
@@ -836,6 +1416,50 @@ class jpegls_encoder final
         return bytes_written;
     }
 
+    /// <summary>
+    /// Resets the encoder to allow the encoding of the next frame, the configured parameters and internal resources are kept.
+    /// Call destination to set the destination of the next frame afterwards.
+    /// </summary>
+    jpegls_encoder& reset()
+    {
+        check_jpegls_errc(charls_jpegls_encoder_reset(encoder_.get()));
+        return *this;
+    }
+
+    /// <summary>
+    /// Sets the callback that receives the stages of the encoding process, a null pointer disables tracing.
+    /// </summary>
+    /// <param name="callback">The callback function, it can be called concurrently from multiple threads.</param>
+    /// <param name="user_context">Pointer that is passed to the callback.</param>
+    /// <returns>Reference to this instance.</returns>
+    jpegls_encoder& trace(const trace_callback callback, void* user_context = nullptr)
+    {
+        check_jpegls_errc(charls_jpegls_encoder_set_trace_callback(encoder_.get(), callback, user_context));
+        return *this;
+    }
+
+    /// <summary>
+    /// Stores the stages of the encoding process in a ring buffer, which must remain valid while the encoder uses it.
+    /// </summary>
+    /// <param name="buffer">The ring buffer that receives the spans.</param>
+    /// <returns>Reference to this instance.</returns>
+    jpegls_encoder& trace(trace_ring_buffer& buffer)
+    {
+        return trace(&trace_ring_buffer::callback, &buffer);
+    }
+
+    /// <summary>
+    /// Returns the counters of the coding events of all frames encoded since the encoder was created or reset.
+    /// Requires a CharLS build with the CMake option CHARLS_ENABLE_STATISTICS, otherwise statistics_not_enabled is thrown.
+    /// </summary>
+    /// <returns>The coding statistics.</returns>
+    CHARLS_NO_DISCARD coding_statistics statistics() const
+    {
+        coding_statistics statistics;
+        check_jpegls_errc(charls_jpegls_encoder_get_statistics(encoder_.get(), &statistics));
+        return statistics;
+    }
+
 private:
     CHARLS_NO_DISCARD static charls_jpegls_encoder* create_encoder()
     {
@@ -851,9 +1475,105 @@ class jpegls_encoder final
         charls_jpegls_encoder_destroy(encoder);
     }
 
+    template<typename RowSource>
+    static int32_t CHARLS_API_CALLING_CONVENTION call_row_source(void* rows, const uint32_t row_count, void* user_context) noexcept
+    {
+        try
+        {
+            (*static_cast<RowSource*>(user_context))(rows, row_count);
+            return 0;
+        }
+        catch (...)
+        {
+            return 1;
+        }
+    }
+
     std::unique_ptr<charls_jpegls_encoder, void (*)(const charls_jpegls_encoder*)> encoder_{create_encoder(), destroy_encoder};
 };
 
+
+/// <summary>
+/// JPEG-LS batch class that encapsulates the C ABI interface calls and provide a native C++ interface.
+/// A batch owns a pool of worker threads that encode or decode multiple independent frames in parallel.
+/// </summary>
+class jpegls_batch final
+{
+public:
+    /// <summary>
+    /// Constructs a jpegls_batch instance and starts its worker threads.
+    /// </summary>
+    /// <param name="thread_count">The number of worker threads, 0 means one thread for every hardware thread.</param>
+    explicit jpegls_batch(const uint32_t thread_count = 0) :
+        batch_{create_batch(thread_count), destroy_batch}
+    {
+    }
+
+    ~jpegls_batch() = default;
+
+    jpegls_batch(const jpegls_batch&) = delete;
+    jpegls_batch(jpegls_batch&&) noexcept = default;
+    jpegls_batch& operator=(const jpegls_batch&) = delete;
+    jpegls_batch& operator=(jpegls_batch&&) noexcept = default;
+
+    /// <summary>
+    /// Encodes all passed frames. The result of every frame is stored in the frame itself.
+    /// </summary>
+    /// <param name="frames">Array with the frames that need to be encoded.</param>
+    /// <param name="frame_count">Number of frames in the array.</param>
+    void encode(batch_encode_frame* frames, const size_t frame_count) const
+    {
+        check_jpegls_errc(charls_jpegls_batch_encode(batch_.get(), frames, frame_count));
+    }
+
+    /// <summary>
+    /// Encodes all frames in the passed container. The result of every frame is stored in the frame itself.
+    /// </summary>
+    /// <param name="frames">A STL like container that provides the functions data() and size().</param>
+    template<typename Container>
+    void encode(Container& frames) const
+    {
+        encode(frames.data(), frames.size());
+    }
+
+    /// <summary>
+    /// Decodes all passed frames. The result of every frame is stored in the frame itself.
+    /// </summary>
+    /// <param name="frames">Array with the frames that need to be decoded.</param>
+    /// <param name="frame_count">Number of frames in the array.</param>
+    void decode(batch_decode_frame* frames, const size_t frame_count) const
+    {
+        check_jpegls_errc(charls_jpegls_batch_decode(batch_.get(), frames, frame_count));
+    }
+
+    /// <summary>
+    /// Decodes all frames in the passed container. The result of every frame is stored in the frame itself.
+    /// </summary>
+    /// <param name="frames">A STL like container that provides the functions data() and size().</param>
+    template<typename Container>
+    void decode(Container& frames) const
+    {
+        decode(frames.data(), frames.size());
+    }
+
+private:
+    CHARLS_NO_DISCARD static charls_jpegls_batch* create_batch(const uint32_t thread_count)
+    {
+        charls_jpegls_batch* batch = charls_jpegls_batch_create(thread_count);
+        if (!batch)
+            throw std::bad_alloc();
+
+        return batch;
+    }
+
+    static void destroy_batch(const charls_jpegls_batch* batch) noexcept
+    {
+        charls_jpegls_batch_destroy(batch);
+    }
+
+    std::unique_ptr<charls_jpegls_batch, void (*)(const charls_jpegls_batch*)> batch_;
+};
+
 } // namespace charls
 
 
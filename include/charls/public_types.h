@@ -15,6 +15,7 @@ namespace charls {
 namespace impl {
 
 #else
+#include <stddef.h>
 #include <stdint.h>
 #endif
 
@@ -48,6 +49,10 @@ enum charls_jpegls_errc
     CHARLS_JPEGLS_ERRC_INVALID_JPEGLS_PRESET_PARAMETER_TYPE = 22,
     CHARLS_JPEGLS_ERRC_JPEGLS_PRESET_EXTENDED_PARAMETER_TYPE_NOT_SUPPORTED = 23,
     CHARLS_JPEGLS_ERRC_MISSING_END_OF_SPIFF_DIRECTORY = 24,
+    CHARLS_JPEGLS_ERRC_RESTART_MARKER_NOT_FOUND = 25,
+    CHARLS_JPEGLS_ERRC_CALLBACK_FAILED = 26,
+    CHARLS_JPEGLS_ERRC_NEED_MORE_DATA = 27,
+    CHARLS_JPEGLS_ERRC_STATISTICS_NOT_ENABLED = 28,
     CHARLS_JPEGLS_ERRC_INVALID_ARGUMENT_WIDTH = 100,
     CHARLS_JPEGLS_ERRC_INVALID_ARGUMENT_HEIGHT = 101,
     CHARLS_JPEGLS_ERRC_INVALID_ARGUMENT_COMPONENT_COUNT = 102,
@@ -142,6 +147,15 @@ enum charls_spiff_entry_tag
     CHARLS_SPIFF_ENTRY_TAG_SET_REFERENCE = 16
 };
 
+enum charls_trace_event
+{
+    CHARLS_TRACE_EVENT_READ_HEADER = 0,
+    CHARLS_TRACE_EVENT_CREATE_CODEC = 1,
+    CHARLS_TRACE_EVENT_SCAN = 2,
+    CHARLS_TRACE_EVENT_PROCESS_LINE = 3,
+    CHARLS_TRACE_EVENT_FLUSH = 4
+};
+
 #ifdef __cplusplus
 }
 }
@@ -278,6 +292,28 @@ enum class jpegls_errc
     /// </summary>
     missing_end_of_spiff_directory = impl::CHARLS_JPEGLS_ERRC_MISSING_END_OF_SPIFF_DIRECTORY,
 
+    /// <summary>
+    /// This error is returned when a restart marker is not found, or found out of sequence, at the end of a restart interval.
+    /// </summary>
+    restart_marker_not_found = impl::CHARLS_JPEGLS_ERRC_RESTART_MARKER_NOT_FOUND,
+
+    /// <summary>
+    /// This error is returned when a row callback function returns a nonzero value to abort the operation.
+    /// </summary>
+    callback_failed = impl::CHARLS_JPEGLS_ERRC_CALLBACK_FAILED,
+
+    /// <summary>
+    /// This status is returned when a partial source buffer doesn't contain enough data to continue decoding.
+    /// Decoding can be continued after the source buffer has been extended with the next received data.
+    /// </summary>
+    need_more_data = impl::CHARLS_JPEGLS_ERRC_NEED_MORE_DATA,
+
+    /// <summary>
+    /// This error is returned when the coding statistics are requested, but CharLS has been built without them
+    /// (CMake option CHARLS_ENABLE_STATISTICS).
+    /// </summary>
+    statistics_not_enabled = impl::CHARLS_JPEGLS_ERRC_STATISTICS_NOT_ENABLED,
+
     /// <summary>
     /// The argument for the width parameter is outside the range [1, 65535].
     /// </summary>
@@ -684,6 +720,41 @@ enum class spiff_entry_tag : uint32_t
     set_reference = impl::CHARLS_SPIFF_ENTRY_TAG_SET_REFERENCE
 };
 
+/// <summary>
+/// Defines the stages of the coding process that are reported to a trace callback.
+/// </summary>
+enum class trace_event : int32_t
+{
+    /// <summary>
+    /// The decoder reads the header segments of the JPEG-LS stream.
+    /// </summary>
+    read_header = impl::CHARLS_TRACE_EVENT_READ_HEADER,
+
+    /// <summary>
+    /// A codec is created for the coding parameters of a scan, the codecs are reused when the parameters don't change.
+    /// </summary>
+    create_codec = impl::CHARLS_TRACE_EVENT_CREATE_CODEC,
+
+    /// <summary>
+    /// A scan is encoded or decoded, the index is the index of the scan. Restart intervals that are decoded in parallel
+    /// each report a span, the index is then the index of the restart interval in the scan.
+    /// </summary>
+    scan = impl::CHARLS_TRACE_EVENT_SCAN,
+
+    /// <summary>
+    /// The pixels of a line are transformed (copied, color transformed, (de)interleaved) between the line buffer
+    /// of the codec and the caller's buffer, the index is the line in the scan.
+    /// Scans that are coded directly in the caller's buffer don't report this event.
+    /// </summary>
+    process_line = impl::CHARLS_TRACE_EVENT_PROCESS_LINE,
+
+    /// <summary>
+    /// The encoder writes the remaining bits of a scan, the decoder passes the last decoded rows to the callback
+    /// or the preview destination.
+    /// </summary>
+    flush = impl::CHARLS_TRACE_EVENT_FLUSH
+};
+
 // Legacy type names, will be removed in next major release.
 using ApiResult CHARLS_DEPRECATED = jpegls_errc;
 using InterleaveMode CHARLS_DEPRECATED = interleave_mode;
@@ -709,6 +780,7 @@ using charls_spiff_color_space = charls::spiff_color_space;
 using charls_spiff_compression_type = charls::spiff_compression_type;
 using charls_spiff_resolution_units = charls::spiff_resolution_units;
 using charls_spiff_entry_tag = charls::spiff_entry_tag;
+using charls_trace_event = charls::trace_event;
 
 // Legacy type names, will be removed in next major release.
 using CharlsApiResultType = charls::jpegls_errc;
@@ -729,6 +801,7 @@ typedef int32_t charls_spiff_profile_id;
 typedef int32_t charls_spiff_color_space;
 typedef int32_t charls_spiff_compression_type;
 typedef int32_t charls_spiff_resolution_units;
+typedef int32_t charls_trace_event;
 
 // Legacy enum names, will be removed in next major release.
 typedef enum charls_jpegls_errc CharlsApiResultType;
@@ -797,6 +870,119 @@ struct charls_frame_info CHARLS_FINAL
     int32_t component_count;
 };
 
+/// <summary>
+/// Defines a rectangular region of interest in a frame.
+/// </summary>
+struct charls_rect CHARLS_FINAL
+{
+    /// <summary>
+    /// Horizontal position of the top left corner of the region.
+    /// </summary>
+    uint32_t x;
+
+    /// <summary>
+    /// Vertical position of the top left corner of the region.
+    /// </summary>
+    uint32_t y;
+
+    /// <summary>
+    /// Width of the region, range [1, frame width - x].
+    /// </summary>
+    uint32_t width;
+
+    /// <summary>
+    /// Height of the region, range [1, frame height - y].
+    /// </summary>
+    uint32_t height;
+};
+
+/// <summary>
+/// Defines how a reduced resolution preview is created while decoding.
+/// </summary>
+struct charls_preview_options CHARLS_FINAL
+{
+    /// <summary>
+    /// Every block of scale_factor x scale_factor pixels is averaged to a single pixel, range [1, 255].
+    /// The width and height of the preview are the width and height of the frame divided by scale_factor, rounded up.
+    /// </summary>
+    uint32_t scale_factor;
+
+    /// <summary>
+    /// Sample value that is mapped to 0 when windowing is used.
+    /// </summary>
+    uint32_t window_low;
+
+    /// <summary>
+    /// Sample value that is mapped to 255 when windowing is used.
+    /// When window_high is larger than window_low the samples are windowed to 8 bits, when both are 0 the bit depth is kept.
+    /// </summary>
+    uint32_t window_high;
+};
+
+/// <summary>
+/// Function definition for a callback that provides the rows of pixels that need to be encoded.
+/// The callback is called with a strip that can hold row_count rows and must fill all of them.
+/// Rows are packed: a row holds width * bytes per sample bytes (multiplied by the component count when interleaved).
+/// In interleave mode none all rows of the first component are requested first, followed by the rows of the next component.
+/// </summary>
+/// <param name="rows">Strip that needs to be filled with the next rows of pixels.</param>
+/// <param name="row_count">The number of rows that need to be written to the strip.</param>
+/// <param name="user_context">The user context passed together with the callback.</param>
+/// <returns>0 to continue, a nonzero value aborts the encode operation.</returns>
+typedef int32_t(CHARLS_API_CALLING_CONVENTION* charls_encode_rows_callback)(void* rows, uint32_t row_count, void* user_context);
+
+/// <summary>
+/// Function definition for a callback that receives the rows of pixels that have been decoded.
+/// Rows are packed and are delivered in the same order as the rows of the charls_encode_rows_callback.
+/// The strip is reused after the callback returns: data that is needed later must be copied.
+/// </summary>
+/// <param name="rows">Strip with the next decoded rows of pixels.</param>
+/// <param name="row_count">The number of rows in the strip.</param>
+/// <param name="user_context">The user context passed together with the callback.</param>
+/// <returns>0 to continue, a nonzero value aborts the decode operation.</returns>
+typedef int32_t(CHARLS_API_CALLING_CONVENTION* charls_decode_rows_callback)(const void* rows, uint32_t row_count, void* user_context);
+
+/// <summary>
+/// Defines a stage of the coding process that has been completed, reported to a trace callback.
+/// </summary>
+struct charls_trace_span CHARLS_FINAL
+{
+    /// <summary>
+    /// The stage of the coding process.
+    /// </summary>
+    charls_trace_event event;
+
+    /// <summary>
+    /// The index of the restart interval for scan events of restart intervals that are decoded in parallel, the index
+    /// of the line in the scan for process line events, otherwise 0.
+    /// </summary>
+    uint32_t index;
+
+    /// <summary>
+    /// The index of the scan for scan events, otherwise 0.
+    /// </summary>
+    uint32_t scan;
+
+    /// <summary>
+    /// Start time in nanoseconds of a monotonic clock (std::chrono::steady_clock), its epoch is not defined.
+    /// </summary>
+    uint64_t start_time;
+
+    /// <summary>
+    /// End time in nanoseconds of the same monotonic clock.
+    /// </summary>
+    uint64_t end_time;
+};
+
+/// <summary>
+/// Function definition for a callback that receives the stages of the coding process when they are completed.
+/// Scans that are coded in parallel report their stages from the worker threads: the callback can be called
+/// concurrently and must be thread safe. The callback should return quickly as it delays the coding process.
+/// </summary>
+/// <param name="span">The completed stage, only valid during the call.</param>
+/// <param name="user_context">The user context passed together with the callback.</param>
+typedef void(CHARLS_API_CALLING_CONVENTION* charls_trace_callback)(const struct charls_trace_span* span, void* user_context);
+
 /// <summary>
 /// Defines the JPEG-LS preset coding parameters as defined in ISO/IEC 14495-1, C.2.4.1.1.
 /// JPEG-LS defines a default set of parameters, but custom parameters can be used.
@@ -831,6 +1017,177 @@ struct charls_jpegls_pc_parameters CHARLS_FINAL
     int32_t reset_value;
 };
 
+/// <summary>
+/// Defines the counters of the events in the coding process, which show how an image has been encoded or decoded.
+/// The counters are only collected when CharLS has been built with the CMake option CHARLS_ENABLE_STATISTICS.
+/// The histograms use log2 buckets: bucket 0 counts the value 0, bucket n counts the values [2^(n-1), 2^n)
+/// and the last bucket also counts all larger values.
+/// </summary>
+struct charls_coding_statistics CHARLS_FINAL
+{
+    /// <summary>
+    /// Number of coded lines. In interleave mode line, a line contains all components.
+    /// </summary>
+    uint64_t line_count;
+
+    /// <summary>
+    /// Number of samples coded in regular mode (with a Golomb code).
+    /// </summary>
+    uint64_t regular_mode_sample_count;
+
+    /// <summary>
+    /// Number of pixels coded as part of a run in run mode, excluding the run interruption pixels.
+    /// </summary>
+    uint64_t run_mode_pixel_count;
+
+    /// <summary>
+    /// Number of runs, a run can have a length of 0.
+    /// </summary>
+    uint64_t run_count;
+
+    /// <summary>
+    /// Number of runs ended by a run interruption pixel (the other runs ended at the end of a line).
+    /// </summary>
+    uint64_t run_interruption_count;
+
+    /// <summary>
+    /// Histogram of the lengths of the runs, in log2 buckets.
+    /// </summary>
+    uint64_t run_length_histogram[17];
+
+    /// <summary>
+    /// Histogram of the Golomb coding parameter k of the samples coded in regular mode, the last entry counts k >= 16.
+    /// </summary>
+    uint64_t golomb_k_histogram[17];
+
+    /// <summary>
+    /// Decoder: number of regular mode samples decoded with a single lookup in the Golomb code decoding tables.
+    /// </summary>
+    uint64_t golomb_table_hit_count;
+
+    /// <summary>
+    /// Decoder: number of regular mode samples with a Golomb code that is too long for the decoding tables.
+    /// </summary>
+    uint64_t golomb_table_miss_count;
+
+    /// <summary>
+    /// Decoder: number of times the bit cache has been filled.
+    /// </summary>
+    uint64_t bit_reader_fill_count;
+
+    /// <summary>
+    /// Decoder: number of times the bit cache has been filled byte by byte, because a 0xFF byte was near.
+    /// </summary>
+    uint64_t bit_reader_slow_fill_count;
+
+    /// <summary>
+    /// Number of 0xFF bytes in the coded bit stream, which are followed by a stuffed 0 bit.
+    /// </summary>
+    uint64_t stuffed_byte_count;
+
+    /// <summary>
+    /// Number of bits of the coded lines, divided by the line count this is the average size of a line.
+    /// </summary>
+    uint64_t coded_bit_count;
+
+    /// <summary>
+    /// Size in bytes of the largest coded line.
+    /// </summary>
+    uint64_t maximum_line_byte_count;
+};
+
+/// <summary>
+/// Defines a single frame that needs to be encoded as part of a batch encode operation.
+/// </summary>
+struct charls_batch_encode_frame CHARLS_FINAL
+{
+    /// <summary>
+    /// Reference to the image data that needs to be encoded.
+    /// </summary>
+    const void* source;
+
+    /// <summary>
+    /// Size of the source buffer in bytes.
+    /// </summary>
+    size_t source_size_bytes;
+
+    /// <summary>
+    /// Number of bytes from one row of pixels in memory to the next row of pixels in memory, 0 means no padding.
+    /// </summary>
+    uint32_t source_stride;
+
+    /// <summary>
+    /// Information about the frame that needs to be encoded.
+    /// </summary>
+    struct charls_frame_info frame_info;
+
+    /// <summary>
+    /// The interleave mode the encoder should use.
+    /// </summary>
+    charls_interleave_mode interleave_mode;
+
+    /// <summary>
+    /// The NEAR parameter the encoder should use, 0 means lossless.
+    /// </summary>
+    int32_t near_lossless;
+
+    /// <summary>
+    /// Reference to the buffer that will hold the encoded JPEG-LS byte stream.
+    /// </summary>
+    void* destination;
+
+    /// <summary>
+    /// Size of the destination buffer in bytes.
+    /// </summary>
+    size_t destination_size_bytes;
+
+    /// <summary>
+    /// Output: the number of bytes written to the destination buffer.
+    /// </summary>
+    size_t bytes_written;
+
+    /// <summary>
+    /// Output: the result of encoding this frame: success or a failure code.
+    /// </summary>
+    charls_jpegls_errc result;
+};
+
+/// <summary>
+/// Defines a single JPEG-LS byte stream that needs to be decoded as part of a batch decode operation.
+/// </summary>
+struct charls_batch_decode_frame CHARLS_FINAL
+{
+    /// <summary>
+    /// Reference to the encoded JPEG-LS byte stream.
+    /// </summary>
+    const void* source;
+
+    /// <summary>
+    /// Size of the source buffer in bytes.
+    /// </summary>
+    size_t source_size_bytes;
+
+    /// <summary>
+    /// Reference to the buffer that will hold the decoded image data.
+    /// </summary>
+    void* destination;
+
+    /// <summary>
+    /// Size of the destination buffer in bytes.
+    /// </summary>
+    size_t destination_size_bytes;
+
+    /// <summary>
+    /// Number of bytes from one row of pixels in memory to the next row of pixels in memory, 0 means no padding.
+    /// </summary>
+    uint32_t destination_stride;
+
+    /// <summary>
+    /// Output: the result of decoding this frame: success or a failure code.
+    /// </summary>
+    charls_jpegls_errc result;
+};
+
 /// <summary>
 /// Defines the JPEG-LS preset coding parameters as defined in ISO/IEC 14495-1, C.2.4.1.1.
 /// JPEG-LS defines a default set of parameters, but custom parameters can be used.
@@ -994,11 +1351,23 @@ namespace charls {
 
 using spiff_header = charls_spiff_header;
 using frame_info = charls_frame_info;
+using preview_options = charls_preview_options;
 using jpegls_pc_parameters = charls_jpegls_pc_parameters;
+using batch_encode_frame = charls_batch_encode_frame;
+using batch_decode_frame = charls_batch_decode_frame;
+using coding_statistics = charls_coding_statistics;
+using encode_rows_callback = charls_encode_rows_callback;
+using decode_rows_callback = charls_decode_rows_callback;
+using trace_span = charls_trace_span;
+using trace_callback = charls_trace_callback;
 
 static_assert(sizeof(spiff_header) == 40, "size of struct is incorrect, check padding settings");
 static_assert(sizeof(frame_info) == 16, "size of struct is incorrect, check padding settings");
+static_assert(sizeof(charls_rect) == 16, "size of struct is incorrect, check padding settings");
+static_assert(sizeof(preview_options) == 12, "size of struct is incorrect, check padding settings");
 static_assert(sizeof(jpegls_pc_parameters) == 20, "size of struct is incorrect, check padding settings");
+static_assert(sizeof(coding_statistics) == 368, "size of struct is incorrect, check padding settings");
+static_assert(sizeof(trace_span) == 32, "size of struct is incorrect, check padding settings");
 
 } // namespace charls
 
@@ -1006,6 +1375,12 @@ static_assert(sizeof(jpegls_pc_parameters) == 20, "size of struct is incorrect,
 
 typedef struct charls_spiff_header charls_spiff_header;
 typedef struct charls_frame_info charls_frame_info;
+typedef struct charls_rect charls_rect;
+typedef struct charls_preview_options charls_preview_options;
 typedef struct charls_jpegls_pc_parameters charls_jpegls_pc_parameters;
+typedef struct charls_batch_encode_frame charls_batch_encode_frame;
+typedef struct charls_batch_decode_frame charls_batch_decode_frame;
+typedef struct charls_coding_statistics charls_coding_statistics;
+typedef struct charls_trace_span charls_trace_span;
 
 #endif
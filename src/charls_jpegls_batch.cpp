@@ -0,0 +1,138 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <charls/charls.h>
+
+#include "util.h"
+#include "work_stealing_pool.h"
+
+#include <new>
+#include <vector>
+
+using namespace charls;
+
+struct charls_jpegls_batch final
+{
+    explicit charls_jpegls_batch(const uint32_t thread_count) :
+        pool_{thread_count},
+        encoders_(pool_.ThreadCount()),
+        decoders_(pool_.ThreadCount())
+    {
+    }
+
+    void encode(batch_encode_frame* frames, const size_t frame_count)
+    {
+        if (frame_count != 0)
+        {
+            check_pointer(frames);
+        }
+
+        pool_.Run(frame_count, [this, frames](const size_t worker_index, const size_t index) noexcept {
+            encode_frame(encoders_[worker_index], frames[index]);
+        });
+    }
+
+    void decode(batch_decode_frame* frames, const size_t frame_count)
+    {
+        if (frame_count != 0)
+        {
+            check_pointer(frames);
+        }
+
+        pool_.Run(frame_count, [this, frames](const size_t worker_index, const size_t index) noexcept {
+            decode_frame(decoders_[worker_index], frames[index]);
+        });
+    }
+
+private:
+    // Every worker reuses its own encoder and decoder instance, this avoids re-creating the codecs for every frame.
+    static void encode_frame(jpegls_encoder& encoder, batch_encode_frame& frame) noexcept
+    {
+        try
+        {
+            encoder.reset()
+                .frame_info(frame.frame_info)
+                .interleave_mode(frame.interleave_mode)
+                .near_lossless(frame.near_lossless)
+                .destination(frame.destination, frame.destination_size_bytes);
+
+            frame.bytes_written = encoder.encode(frame.source, frame.source_size_bytes, frame.source_stride);
+            frame.result = jpegls_errc::success;
+        }
+        catch (...)
+        {
+            frame.bytes_written = 0;
+            frame.result = to_jpegls_errc();
+        }
+    }
+
+    static void decode_frame(jpegls_decoder& decoder, batch_decode_frame& frame) noexcept
+    {
+        try
+        {
+            decoder.reset()
+                .source(frame.source, frame.source_size_bytes)
+                .read_header()
+                .decode(frame.destination, frame.destination_size_bytes, frame.destination_stride);
+            frame.result = jpegls_errc::success;
+        }
+        catch (...)
+        {
+            frame.result = to_jpegls_errc();
+        }
+    }
+
+    WorkStealingPool pool_;
+    std::vector<jpegls_encoder> encoders_;
+    std::vector<jpegls_decoder> decoders_;
+};
+
+
+extern "C" {
+
+charls_jpegls_batch* CHARLS_API_CALLING_CONVENTION
+charls_jpegls_batch_create(const uint32_t thread_count) noexcept
+try
+{
+    MSVC_WARNING_SUPPRESS(26402 26409) // don't use new and delete + scoped object and move
+    return new charls_jpegls_batch(thread_count);
+    MSVC_WARNING_UNSUPPRESS()
+}
+catch (...)
+{
+    return nullptr;
+}
+
+void CHARLS_API_CALLING_CONVENTION
+charls_jpegls_batch_destroy(const charls_jpegls_batch* batch) noexcept
+{
+    MSVC_WARNING_SUPPRESS(26401 26409) // don't use new and delete + non-owner.
+    delete batch;
+    MSVC_WARNING_UNSUPPRESS()
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_batch_encode(charls_jpegls_batch* batch, batch_encode_frame* frames, const size_t frame_count) noexcept
+try
+{
+    check_pointer(batch)->encode(frames, frame_count);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_batch_decode(charls_jpegls_batch* batch, batch_decode_frame* frames, const size_t frame_count) noexcept
+try
+{
+    check_pointer(batch)->decode(frames, frame_count);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+}
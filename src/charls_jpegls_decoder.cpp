@@ -4,6 +4,9 @@
 #include <charls/charls.h>
 
 #include "jpeg_stream_reader.h"
+#include "preview_stream_buffer.h"
+#include "strip_stream_buffer.h"
+#include "trace.h"
 #include "util.h"
 
 #include <cassert>
@@ -15,26 +18,123 @@ using namespace charls;
 
 struct charls_jpegls_decoder final
 {
-    void source(const void* source_buffer, size_t source_size_bytes)
+    void source(const void* source_buffer, size_t source_size_bytes, const bool partial = false)
     {
         if (state_ != state::initial)
             throw jpegls_error{jpegls_errc::invalid_operation};
 
         source_buffer_ = source_buffer;
         size_ = source_size_bytes;
+        partial_ = partial;
+        region_ = {};
+        preview_ = {};
+        strip_destination_.reset();
+        row_index_ = {};
 
         ByteStreamInfo source{FromByteArrayConst(source_buffer_, size_)};
-        reader_ = std::make_unique<JpegStreamReader>(source);
+        if (reader_)
+        {
+            reader_->Reset(source);
+        }
+        else
+        {
+            reader_ = std::make_unique<JpegStreamReader>(source);
+        }
+        reader_->SetPartialSource(partial_);
+        reader_->SetParallelDecoding(parallel_decoding_);
+        reader_->SetTracer(tracer_);
+        reader_->SetRowIndex(nullptr);
         state_ = state::source_set;
     }
 
+    void extend_source(const void* source_buffer, const size_t source_size_bytes)
+    {
+        if (state_ == state::initial || !partial_)
+            throw jpegls_error{jpegls_errc::invalid_operation};
+
+        if (source_size_bytes < size_)
+            throw jpegls_error{jpegls_errc::invalid_argument};
+
+        source_buffer_ = source_buffer;
+        size_ = source_size_bytes;
+        reader_->ExtendSource(FromByteArrayConst(source_buffer_, size_));
+    }
+
+    void rewind()
+    {
+        if (state_ < state::header_read || partial_)
+            throw jpegls_error{jpegls_errc::invalid_operation};
+
+        // The source buffer is the same: the row index that was built for it remains valid.
+        RowIndex row_index{std::move(row_index_)};
+        state_ = state::initial;
+        source(source_buffer_, size_);
+        row_index_ = std::move(row_index);
+        reader_->SetRowIndex(row_index_.complete ? &row_index_ : nullptr);
+        read_header();
+    }
+
+    void reset() noexcept
+    {
+        // The reader is kept to allow reuse of its cached codecs by the next decode operation.
+        state_ = state::initial;
+
+#ifdef CHARLS_ENABLE_STATISTICS
+        if (reader_)
+        {
+            reader_->ResetStatistics();
+        }
+#endif
+    }
+
+    void trace(const trace_callback callback, void* user_context) noexcept
+    {
+        tracer_ = {callback, user_context};
+        if (reader_)
+        {
+            reader_->SetTracer(tracer_);
+        }
+    }
+
+    coding_statistics statistics() const
+    {
+#ifdef CHARLS_ENABLE_STATISTICS
+        coding_statistics total{};
+        if (reader_)
+        {
+            reader_->AddStatistics(total);
+        }
+
+        return total;
+#else
+        throw jpegls_error{jpegls_errc::statistics_not_enabled};
+#endif
+    }
+
+    void parallel_decoding(const bool value) noexcept
+    {
+        parallel_decoding_ = value;
+        if (reader_)
+        {
+            reader_->SetParallelDecoding(value);
+        }
+    }
+
     bool read_header(spiff_header* spiff_header)
     {
         if (state_ != state::source_set)
             throw jpegls_error{jpegls_errc::invalid_operation};
 
         bool spiff_header_found{};
-        reader_->ReadHeader(spiff_header, &spiff_header_found);
+        try
+        {
+            reader_->ReadHeader(spiff_header, &spiff_header_found);
+        }
+        catch (const jpegls_error&)
+        {
+            rewind_partial_source();
+            throw;
+        }
         state_ = spiff_header_found ? state::spiff_header_read : state::spiff_header_not_found;
 
         return spiff_header_found;
@@ -45,12 +145,20 @@ struct charls_jpegls_decoder final
         if (state_ == state::initial || state_ >= state::header_read)
             throw jpegls_error{jpegls_errc::invalid_operation};
 
-        if (state_ != state::spiff_header_not_found)
+        try
         {
-            reader_->ReadHeader();
-        }
+            if (state_ != state::spiff_header_not_found)
+            {
+                reader_->ReadHeader();
+            }
 
-        reader_->ReadStartOfScan(true);
+            reader_->ReadStartOfScan(true);
+        }
+        catch (const jpegls_error&)
+        {
+            rewind_partial_source();
+            throw;
+        }
         state_ = state::header_read;
     }
 
@@ -94,7 +202,7 @@ struct charls_jpegls_decoder final
 
     size_t destination_size(const uint32_t stride) const
     {
-        const charls::frame_info info{frame_info()};
+        const charls::frame_info info{preview_frame_info()};
 
         if (stride == 0)
         {
@@ -120,15 +228,83 @@ struct charls_jpegls_decoder final
         if (state_ != state::header_read)
             throw jpegls_error{jpegls_errc::invalid_operation};
 
-        if (stride != 0)
+        if (preview_.scale_factor != 0)
         {
-            reader_->GetMetadata().stride = static_cast<int32_t>(stride);
+            decode_preview(destination_buffer, destination_size_bytes, stride);
+            return;
         }
 
+        reader_->GetMetadata().stride = static_cast<int32_t>(stride != 0 ? stride : packed_row_size());
+
         const ByteStreamInfo destination = FromByteArray(destination_buffer, destination_size_bytes);
         reader_->Read(destination);
     }
 
+    void decode_to_callback(void* strip, const size_t strip_size, const decode_rows_callback callback, void* user_context)
+    {
+        if (state_ != state::header_read || preview_.scale_factor != 0)
+            throw jpegls_error{jpegls_errc::invalid_operation};
+
+        // The decoding of a partial source continues with the strip destination of the previous call.
+        if (!strip_destination_)
+        {
+            const size_t row_size = packed_row_size();
+            reader_->GetMetadata().stride = static_cast<int32_t>(row_size);
+            strip_destination_ = std::make_unique<StripDestinationBuffer>(strip, strip_size, row_size, callback, user_context);
+        }
+
+        try
+        {
+            reader_->Read({strip_destination_.get(), nullptr, 0});
+        }
+        catch (const jpegls_error& error)
+        {
+            if (error.code() != jpegls_errc::need_more_data)
+            {
+                strip_destination_.reset();
+                throw;
+            }
+
+            // Pass the rows decoded so far, to allow the caller to process them while waiting for more data.
+            strip_destination_->FlushRows();
+            throw;
+        }
+
+        {
+            const TraceSpan span{tracer_, trace_event::flush};
+            strip_destination_->FlushRows();
+        }
+        strip_destination_.reset();
+    }
+
+    void build_row_index(const uint32_t row_interval)
+    {
+        if (state_ != state::header_read || partial_ || region_.Width > 0)
+            throw jpegls_error{jpegls_errc::invalid_operation};
+
+        if (row_interval == 0)
+            throw jpegls_error{jpegls_errc::invalid_argument};
+
+        row_index_ = {row_interval, false, {}};
+        reader_->SetRowIndex(&row_index_);
+
+        // The index is built by decoding the complete image, the decoded pixels are not needed.
+        DiscardStreamBuffer discard;
+        try
+        {
+            reader_->Read({&discard, nullptr, 0});
+        }
+        catch (const jpegls_error&)
+        {
+            row_index_ = {};
+            reader_->SetRowIndex(nullptr);
+            throw;
+        }
+
+        // Rewind to the start of the image to allow decoding of the frame (or a region of it) with the index.
+        rewind();
+    }
+
     void output_bgr(char value) const noexcept
     {
         reader_->SetOutputBgr(value);
@@ -139,12 +315,115 @@ struct charls_jpegls_decoder final
         return reader_->GetMetadata();
     }
 
-    void region(const JlsRect& rect) const noexcept
+    void region(const JlsRect& rect) noexcept
     {
+        region_ = rect;
         reader_->SetRect(rect);
     }
 
+    void region(const charls_rect& rect)
+    {
+        if (state_ != state::header_read)
+            throw jpegls_error{jpegls_errc::invalid_operation};
+
+        const charls::frame_info info{frame_info()};
+        if (rect.width == 0 || rect.height == 0 || rect.x >= info.width || rect.y >= info.height ||
+            rect.width > info.width - rect.x || rect.height > info.height - rect.y)
+            throw jpegls_error{jpegls_errc::invalid_argument};
+
+        region(JlsRect{static_cast<int32_t>(rect.x), static_cast<int32_t>(rect.y), static_cast<int32_t>(rect.width), static_cast<int32_t>(rect.height)});
+    }
+
+    void preview(const preview_options& options)
+    {
+        if (state_ != state::header_read || partial_)
+            throw jpegls_error{jpegls_errc::invalid_operation};
+
+        if (options.scale_factor == 0 || options.scale_factor > 255 || options.window_high < options.window_low ||
+            (options.window_high == options.window_low && options.window_low != 0))
+            throw jpegls_error{jpegls_errc::invalid_argument};
+
+        preview_ = options;
+    }
+
 private:
+    // The decoded rows are reduced by a stream buffer, the (region of the) frame is decoded as a packed stream of rows.
+    void decode_preview(void* destination_buffer, const size_t destination_size_bytes, const uint32_t stride) const
+    {
+        const charls::frame_info info{region_frame_info()};
+        const charls::frame_info preview_info{preview_frame_info()};
+        const bool interleaved = interleave_mode() != interleave_mode::none;
+        const size_t bytes_per_sample = preview_info.bits_per_sample <= 8 ? 1 : 2;
+        const size_t preview_row_size = static_cast<size_t>(preview_info.width) * bytes_per_sample * (interleaved ? preview_info.component_count : 1);
+
+        if (destination_size_bytes < destination_size(stride))
+            throw jpegls_error{jpegls_errc::destination_buffer_too_small};
+
+        PreviewDestinationBuffer preview_destination{destination_buffer, destination_size_bytes,
+                                                     stride != 0 ? stride : preview_row_size,
+                                                     info.width, info.height, interleaved ? info.component_count : 1,
+                                                     info.bits_per_sample <= 8 ? 1U : 2U, preview_};
+        reader_->GetMetadata().stride = static_cast<int32_t>(packed_row_size());
+        reader_->Read({&preview_destination, nullptr, 0});
+
+        const TraceSpan span{tracer_, trace_event::flush};
+        preview_destination.Flush();
+    }
+
+    // The frame info of the decoded pixels: the size of the region and preview and the bit depth after windowing.
+    charls::frame_info preview_frame_info() const
+    {
+        charls::frame_info info{region_frame_info()};
+        if (preview_.scale_factor != 0)
+        {
+            info.width = PreviewDestinationBuffer::PreviewSize(info.width, preview_.scale_factor);
+            info.height = PreviewDestinationBuffer::PreviewSize(info.height, preview_.scale_factor);
+            if (preview_.window_high > preview_.window_low)
+            {
+                info.bits_per_sample = 8;
+            }
+        }
+
+        return info;
+    }
+
+    // The frame info with the width and height of the region of interest, when one is set.
+    charls::frame_info region_frame_info() const
+    {
+        charls::frame_info info{frame_info()};
+        if (region_.Width > 0)
+        {
+            info.width = static_cast<uint32_t>(region_.Width);
+            info.height = static_cast<uint32_t>(region_.Height);
+        }
+
+        return info;
+    }
+
+    // The size in bytes of a row of decoded pixels without padding.
+    size_t packed_row_size() const
+    {
+        const charls::frame_info info{region_frame_info()};
+        size_t row_size = static_cast<size_t>(info.width) * (info.bits_per_sample <= 8 ? 1 : 2);
+        if (interleave_mode() != interleave_mode::none)
+        {
+            row_size *= static_cast<size_t>(info.component_count);
+        }
+
+        return row_size;
+    }
+
+    // A header of a partial source that could not be read completely is read again from the start.
+    void rewind_partial_source()
+    {
+        if (!partial_)
+            return;
+
+        reader_->Reset(FromByteArrayConst(source_buffer_, size_));
+        reader_->SetPartialSource(true);
+        state_ = state::source_set;
+    }
+
     enum class state
     {
         initial,
@@ -159,6 +438,13 @@ struct charls_jpegls_decoder final
     unique_ptr<JpegStreamReader> reader_;
     const void* source_buffer_{};
     size_t size_{};
+    bool partial_{};
+    bool parallel_decoding_{};
+    JlsRect region_{};
+    preview_options preview_{};
+    RowIndex row_index_{};
+    unique_ptr<StripDestinationBuffer> strip_destination_;
+    Tracer tracer_{};
 };
 
 
@@ -192,6 +478,42 @@ catch (...)
     return to_jpegls_errc();
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_partial_source_buffer(charls_jpegls_decoder* decoder, const void* source_buffer, size_t source_size_bytes) noexcept
+try
+{
+    check_pointer(decoder)->source(check_pointer(source_buffer), source_size_bytes, true);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_extend_source_buffer(charls_jpegls_decoder* decoder, const void* source_buffer, size_t source_size_bytes) noexcept
+try
+{
+    check_pointer(decoder)->extend_source(check_pointer(source_buffer), source_size_bytes);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_parallel_decoding(charls_jpegls_decoder* decoder, const bool parallel_decoding) noexcept
+try
+{
+    check_pointer(decoder)->parallel_decoding(parallel_decoding);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_decoder_read_spiff_header(charls_jpegls_decoder* const decoder, charls_spiff_header* spiff_header, int32_t* header_found) noexcept
 try
@@ -264,6 +586,42 @@ catch (...)
     return to_jpegls_errc();
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_build_row_index(charls_jpegls_decoder* decoder, const uint32_t row_interval) noexcept
+try
+{
+    check_pointer(decoder)->build_row_index(row_interval);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_preview(charls_jpegls_decoder* decoder, const charls_preview_options* options) noexcept
+try
+{
+    check_pointer(decoder)->preview(*check_pointer(options));
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_region(charls_jpegls_decoder* decoder, const charls_rect* region) noexcept
+try
+{
+    check_pointer(decoder)->region(*check_pointer(region));
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_decoder_get_destination_size(const struct charls_jpegls_decoder* decoder, const uint32_t stride, size_t* destination_size_bytes) noexcept
 try
@@ -288,6 +646,66 @@ catch (...)
     return to_jpegls_errc();
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_decode_to_callback(charls_jpegls_decoder* decoder, void* strip, size_t strip_size, charls_decode_rows_callback callback, void* user_context) noexcept
+try
+{
+    check_pointer(decoder)->decode_to_callback(check_pointer(strip), strip_size, check_pointer(callback), user_context);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_reset(charls_jpegls_decoder* decoder) noexcept
+try
+{
+    check_pointer(decoder)->reset();
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_rewind(charls_jpegls_decoder* decoder) noexcept
+try
+{
+    check_pointer(decoder)->rewind();
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_trace_callback(charls_jpegls_decoder* decoder, const charls_trace_callback callback, void* user_context) noexcept
+try
+{
+    check_pointer(decoder)->trace(callback, user_context);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_get_statistics(const charls_jpegls_decoder* decoder, charls_coding_statistics* statistics) noexcept
+try
+{
+    *check_pointer(statistics) = check_pointer(decoder)->statistics();
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 
 jpegls_errc CHARLS_API_CALLING_CONVENTION
 JpegLsReadHeader(const void* source, size_t sourceLength, JlsParameters* params, char* errorMessage)
@@ -7,13 +7,19 @@
 #include "jls_codec_factory.h"
 #include "jpeg_stream_writer.h"
 #include "jpegls_preset_coding_parameters.h"
+#include "parallel_for.h"
+#include "strip_stream_buffer.h"
+#include "trace.h"
 #include "util.h"
 
+#include <algorithm>
 #include <cassert>
 #include <new>
+#include <vector>
 
 using namespace charls;
 using std::unique_ptr;
+using std::vector;
 
 struct charls_jpegls_encoder final
 {
@@ -77,14 +83,46 @@ struct charls_jpegls_encoder final
         color_transformation_ = color_transformation;
     }
 
+    void restart_interval(const uint32_t restart_interval)
+    {
+        if (restart_interval > maximum_restart_interval)
+            throw jpegls_error{jpegls_errc::invalid_argument};
+
+        restart_interval_ = restart_interval;
+    }
+
+    void parallel_components(const bool value) noexcept
+    {
+        parallel_components_ = value;
+    }
+
     size_t estimated_destination_size() const
     {
         if (!is_frame_info_configured())
             throw jpegls_error{jpegls_errc::invalid_operation};
 
-        return static_cast<size_t>(frame_info_.width) * frame_info_.height *
-                   frame_info_.component_count * (frame_info_.bits_per_sample < 9 ? 1 : 2) +
-               1024 + spiff_header_size_in_bytes;
+        return estimated_scan_size(frame_info_.component_count) + 1024 + spiff_header_size_in_bytes;
+    }
+
+    // Returns the estimated size of the coded data of a scan (or of all scans) with component_count components.
+    size_t estimated_scan_size(const int32_t component_count) const noexcept
+    {
+        // Images without redundancy (noise) are coded with more bits than their bit depth: uniform noise needs up to
+        // 8.84 bits per 8 bit sample. 2 extra bits per sample cover these images with a margin.
+        const size_t sample_count = static_cast<size_t>(frame_info_.width) * frame_info_.height * static_cast<size_t>(component_count);
+        size_t size = sample_count * (frame_info_.bits_per_sample < 9 ? 1 : 2) + sample_count / 4;
+
+        // Every restart interval starts with a reset of the context parameters: the first samples of an interval are coded
+        // before the contexts have adapted and can take up to the maximum code length (LIMIT bits). Reserve the restart
+        // marker and the first line of every interval (of every component) at the maximum code length.
+        if (restart_interval_ != 0)
+        {
+            const size_t interval_count = (static_cast<size_t>(frame_info_.height) + restart_interval_ - 1) / restart_interval_;
+            const auto maximum_code_length = static_cast<size_t>(2 * (frame_info_.bits_per_sample + std::max(8, frame_info_.bits_per_sample)));
+            size += interval_count * static_cast<size_t>(component_count) * (2 + frame_info_.width * maximum_code_length / 8);
+        }
+
+        return size;
     }
 
     void write_spiff_header(const spiff_header& spiff_header)
@@ -141,13 +179,90 @@ struct charls_jpegls_encoder final
 
         if (stride == 0)
         {
-            stride = frame_info_.width * ((frame_info_.bits_per_sample + 7) / 8);
-            if (interleave_mode_ != charls::interleave_mode::none)
-            {
-                stride *= frame_info_.component_count;
-            }
+            stride = packed_row_size();
         }
 
+        encode(FromByteArrayConst(source, source_size), stride);
+    }
+
+    void encode_from_callback(void* strip, const size_t strip_size, const encode_rows_callback callback, void* user_context)
+    {
+        if (!is_frame_info_configured() || state_ == state::initial)
+            throw jpegls_error{jpegls_errc::invalid_operation};
+
+        const uint32_t row_size = packed_row_size();
+        const uint32_t row_count = interleave_mode_ == charls::interleave_mode::none ? frame_info_.height * static_cast<uint32_t>(frame_info_.component_count) : frame_info_.height;
+        StripSourceBuffer source{strip, strip_size, row_size, row_count, callback, user_context};
+
+        encode({&source, nullptr, 0}, row_size);
+    }
+
+    size_t bytes_written() const noexcept
+    {
+        return writer_.GetBytesWritten();
+    }
+
+    void reset() noexcept
+    {
+        // Keep the configured parameters and the cached codecs, only the destination needs to be set again.
+        writer_ = JpegStreamWriter{};
+        state_ = state::initial;
+
+#ifdef CHARLS_ENABLE_STATISTICS
+        for (auto& codec : codecs_)
+        {
+            codec.ResetStatistics();
+        }
+#endif
+    }
+
+    void trace(const trace_callback callback, void* user_context) noexcept
+    {
+        tracer_ = {callback, user_context};
+    }
+
+    coding_statistics statistics() const
+    {
+#ifdef CHARLS_ENABLE_STATISTICS
+        coding_statistics total{};
+        for (const auto& codec : codecs_)
+        {
+            codec.AddStatistics(total);
+        }
+
+        return total;
+#else
+        throw jpegls_error{jpegls_errc::statistics_not_enabled};
+#endif
+    }
+
+private:
+    enum class state
+    {
+        initial,
+        destination_set,
+        spiff_header,
+        completed,
+    };
+
+    bool is_frame_info_configured() const noexcept
+    {
+        return frame_info_.width != 0;
+    }
+
+    uint32_t packed_row_size() const noexcept
+    {
+        uint32_t row_size = frame_info_.width * ((frame_info_.bits_per_sample + 7) / 8);
+        if (interleave_mode_ != charls::interleave_mode::none)
+        {
+            row_size *= static_cast<uint32_t>(frame_info_.component_count);
+        }
+
+        return row_size;
+    }
+
+    void encode(ByteStreamInfo sourceInfo, const uint32_t stride)
+    {
         if (state_ == state::spiff_header)
         {
             writer_.WriteSpiffEndOfDirectoryEntry();
@@ -174,48 +289,80 @@ struct charls_jpegls_encoder final
             writer_.WriteJpegLSPresetParametersSegment(preset);
         }
 
-        ByteStreamInfo sourceInfo = FromByteArrayConst(source, source_size);
+        if (restart_interval_ != 0)
+        {
+            writer_.WriteDefineRestartIntervalSegment(restart_interval_);
+        }
+
         if (interleave_mode_ == charls::interleave_mode::none)
         {
             const int32_t byteCountComponent = frame_info_.width * frame_info_.height * ((frame_info_.bits_per_sample + 7) / 8);
-            for (int32_t component = 0; component < frame_info_.component_count; ++component)
+            if (parallel_components_ && frame_info_.component_count > 1 && !sourceInfo.rawStream)
             {
-                writer_.WriteStartOfScanSegment(1, near_lossless_, interleave_mode_);
-                encode_scan(sourceInfo, stride, 1);
-
-                // Synchronize the source stream (EncodeScan works on a local copy)
-                SkipBytes(sourceInfo, byteCountComponent);
+                encode_components_in_parallel(sourceInfo, stride, byteCountComponent);
+            }
+            else
+            {
+                // A stream source provides the components one after the other, these scans need to be encoded in order.
+                // Without the parallel mode the scans are encoded in order directly into the destination.
+                for (int32_t component{}; component < frame_info_.component_count; ++component)
+                {
+                    writer_.WriteStartOfScanSegment(1, near_lossless_, interleave_mode_);
+                    encode_scan(sourceInfo, stride, 1, static_cast<uint32_t>(component));
+                    SkipBytes(sourceInfo, static_cast<size_t>(byteCountComponent));
+                }
             }
         }
         else
         {
             writer_.WriteStartOfScanSegment(frame_info_.component_count, near_lossless_, interleave_mode_);
-            encode_scan(sourceInfo, stride, frame_info_.component_count);
+            encode_scan(sourceInfo, stride, frame_info_.component_count, 0);
         }
 
         writer_.WriteEndOfImage();
     }
 
-    size_t bytes_written() const noexcept
+    void encode_scan(const ByteStreamInfo source, const uint32_t stride, const int32_t component_count, const uint32_t scan_index)
     {
-        return writer_.GetBytesWritten();
+        // Synchronize the destination encapsulated in the writer (EncodeScan works on a local copy)
+        writer_.Seek(encode_scan(source, stride, component_count, scan_index, writer_.OutputStream(), codec_cache(0)));
     }
 
-private:
-    enum class state
+    // The scans of the components are independent in interleave mode none: encode every scan
+    // into a private buffer on its own worker and write the scans in order when all are done.
+    void encode_components_in_parallel(ByteStreamInfo source, const uint32_t stride, const int32_t byteCountComponent)
     {
-        initial,
-        destination_set,
-        spiff_header,
-        completed,
-    };
+        const auto component_count = static_cast<size_t>(frame_info_.component_count);
+        vector<vector<uint8_t>> scans(component_count);
+        vector<size_t> scan_sizes(component_count);
+        codec_cache(component_count - 1);
+        ParallelFor(component_count, [&](const size_t component) {
+            ByteStreamInfo componentSource{source};
+            SkipBytes(componentSource, component * byteCountComponent);
+            scans[component].resize(estimated_scan_size(1) + 1024); // The fixed margin covers the long codes of small images.
+            scan_sizes[component] = encode_scan(componentSource, stride, 1, static_cast<uint32_t>(component),
+                                                FromByteArray(scans[component].data(), scans[component].size()), codecs_[component]);
+        });
+
+        for (size_t component{}; component < component_count; ++component)
+        {
+            writer_.WriteStartOfScanSegment(1, near_lossless_, interleave_mode_);
+            writer_.WriteScanData(scans[component].data(), scan_sizes[component]);
+        }
+    }
 
-    bool is_frame_info_configured() const noexcept
+    CodecCache<EncoderStrategy>& codec_cache(const size_t index)
     {
-        return frame_info_.width != 0;
+        if (codecs_.size() <= index)
+        {
+            codecs_.resize(index + 1);
+        }
+
+        return codecs_[index];
     }
 
-    void encode_scan(ByteStreamInfo source, const uint32_t stride, const int32_t component_count)
+    size_t encode_scan(const ByteStreamInfo source, const uint32_t stride, const int32_t component_count, const uint32_t scan_index,
+                       ByteStreamInfo destination, CodecCache<EncoderStrategy>& cache) const
     {
         JlsParameters info{};
         info.components = component_count;
@@ -225,23 +372,27 @@ struct charls_jpegls_encoder final
         info.stride = stride;
         info.interleaveMode = interleave_mode_;
         info.allowedLossyError = near_lossless_;
-
-        auto codec = JlsCodecFactory<EncoderStrategy>().CreateCodec(info, preset_coding_parameters_);
-        unique_ptr<ProcessLine> processLine(codec->CreateProcess(source));
-        ByteStreamInfo destination{writer_.OutputStream()};
-        const size_t bytesWritten = codec->EncodeScan(move(processLine), destination);
-
-        // Synchronize the destination encapsulated in the writer (EncodeScan works on a local copy)
-        writer_.Seek(bytesWritten);
+        info.colorTransformation = color_transformation_;
+
+        EncoderStrategy& codec = cache.GetCodec(info, preset_coding_parameters_, tracer_);
+        codec.SetRestartInterval(restart_interval_);
+        codec.SetNativeByteOrderStream(true); // The only stream source of the encoder is the strip of encode_from_callback.
+        const TraceSpan span{tracer_, trace_event::scan, 0, scan_index};
+        unique_ptr<ProcessLine> processLine(codec.CreateProcess(source));
+        return codec.EncodeScan(move(processLine), destination);
     }
 
     charls_frame_info frame_info_{};
     int32_t near_lossless_{};
     charls::interleave_mode interleave_mode_{};
     charls::color_transformation color_transformation_{};
+    uint32_t restart_interval_{};
+    bool parallel_components_{};
     state state_{};
     JpegStreamWriter writer_;
     jpegls_pc_parameters preset_coding_parameters_{};
+    vector<CodecCache<EncoderStrategy>> codecs_;
+    Tracer tracer_{};
 };
 
 extern "C" {
@@ -334,6 +485,30 @@ catch (...)
     return to_jpegls_errc();
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_restart_interval(charls_jpegls_encoder* encoder, uint32_t restart_interval) noexcept
+try
+{
+    check_pointer(encoder)->restart_interval(restart_interval);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_parallel_components(charls_jpegls_encoder* encoder, const bool parallel_components) noexcept
+try
+{
+    check_pointer(encoder)->parallel_components(parallel_components);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_get_estimated_destination_size(const charls_jpegls_encoder* encoder, size_t* size_in_bytes) noexcept
 try
@@ -346,6 +521,18 @@ catch (...)
     return to_jpegls_errc();
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_encode_from_callback(charls_jpegls_encoder* encoder, void* strip, size_t strip_size, charls_encode_rows_callback callback, void* user_context) noexcept
+try
+{
+    check_pointer(encoder)->encode_from_callback(check_pointer(strip), strip_size, check_pointer(callback), user_context);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_get_bytes_written(const charls_jpegls_encoder* encoder, size_t* bytes_written) noexcept
 try
@@ -358,6 +545,42 @@ catch (...)
     return to_jpegls_errc();
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_reset(charls_jpegls_encoder* encoder) noexcept
+try
+{
+    check_pointer(encoder)->reset();
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_trace_callback(charls_jpegls_encoder* encoder, const charls_trace_callback callback, void* user_context) noexcept
+try
+{
+    check_pointer(encoder)->trace(callback, user_context);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_get_statistics(const charls_jpegls_encoder* encoder, charls_coding_statistics* statistics) noexcept
+try
+{
+    *check_pointer(statistics) = check_pointer(encoder)->statistics();
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_encode_from_buffer(charls_jpegls_encoder* encoder, const void* source_buffer, const size_t source_size, const uint32_t stride) noexcept
 try
@@ -0,0 +1,79 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <charls/public_types.h>
+
+#include "util.h"
+
+#include <algorithm>
+
+// The coding statistics count events in the inner loops of the codec. When CharLS is built without
+// CHARLS_ENABLE_STATISTICS the COUNT_EVENT statements are removed and the counters don't exist.
+#ifdef CHARLS_ENABLE_STATISTICS
+#define COUNT_EVENT(statement) statement
+#else
+#define COUNT_EVENT(statement)
+#endif
+
+namespace charls {
+
+constexpr size_t statistics_histogram_size = sizeof(coding_statistics::run_length_histogram) / sizeof(uint64_t);
+
+// Returns the log2 bucket of value: 0 for 0, n for [2^(n-1), 2^n), limited to the last bucket of the histograms.
+inline size_t GetHistogramBucket(const uint32_t value) noexcept
+{
+    if (value == 0)
+        return 0;
+
+    return std::min(static_cast<size_t>(32 - CountLeadingZeros(value)), statistics_histogram_size - 1);
+}
+
+inline void AddRegularSample(coding_statistics& statistics, const int32_t k) noexcept
+{
+    ++statistics.regular_mode_sample_count;
+    ++statistics.golomb_k_histogram[std::min(static_cast<size_t>(k), statistics_histogram_size - 1)];
+}
+
+inline void AddRun(coding_statistics& statistics, const int32_t runLength, const bool interrupted) noexcept
+{
+    ++statistics.run_count;
+    statistics.run_mode_pixel_count += static_cast<uint64_t>(runLength);
+    ++statistics.run_length_histogram[GetHistogramBucket(static_cast<uint32_t>(runLength))];
+    if (interrupted)
+    {
+        ++statistics.run_interruption_count;
+    }
+}
+
+inline void AddLine(coding_statistics& statistics, const uint64_t bitCount) noexcept
+{
+    ++statistics.line_count;
+    statistics.coded_bit_count += bitCount;
+    statistics.maximum_line_byte_count = std::max(statistics.maximum_line_byte_count, (bitCount + 7) / 8);
+}
+
+// Adds the counters of source to total, the maximum line size is the largest of both.
+inline void MergeStatistics(coding_statistics& total, const coding_statistics& source) noexcept
+{
+    total.line_count += source.line_count;
+    total.regular_mode_sample_count += source.regular_mode_sample_count;
+    total.run_mode_pixel_count += source.run_mode_pixel_count;
+    total.run_count += source.run_count;
+    total.run_interruption_count += source.run_interruption_count;
+    for (size_t i = 0; i < statistics_histogram_size; ++i)
+    {
+        total.run_length_histogram[i] += source.run_length_histogram[i];
+        total.golomb_k_histogram[i] += source.golomb_k_histogram[i];
+    }
+    total.golomb_table_hit_count += source.golomb_table_hit_count;
+    total.golomb_table_miss_count += source.golomb_table_miss_count;
+    total.bit_reader_fill_count += source.bit_reader_fill_count;
+    total.bit_reader_slow_fill_count += source.bit_reader_slow_fill_count;
+    total.stuffed_byte_count += source.stuffed_byte_count;
+    total.coded_bit_count += source.coded_bit_count;
+    total.maximum_line_byte_count = std::max(total.maximum_line_byte_count, source.maximum_line_byte_count);
+}
+
+} // namespace charls
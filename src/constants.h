@@ -22,6 +22,7 @@ constexpr int MaximumComponentCount = 255;
 constexpr int MinimumBitsPerSample = 2;
 constexpr int MaximumBitsPerSample = 16;
 constexpr int maximum_near_lossless = 255;
+constexpr uint32_t maximum_restart_interval = 65535; // Limited by the 16 bit Ri field of the DRI segment.
 
 constexpr int MaximumNearLossless(const int maximumSampleValue) noexcept
 {
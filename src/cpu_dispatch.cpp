@@ -0,0 +1,289 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <charls/charls.h>
+
+#include "cpu_dispatch.h"
+#include "util.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CHARLS_X86_KERNELS
+#include <immintrin.h>
+
+// The AVX-512 intrinsics that return a compare mask are not available before Visual Studio 2017.
+#if !defined(_MSC_VER) || _MSC_VER >= 1910
+#define CHARLS_AVX512_KERNELS
+#endif
+#endif
+
+// GCC and clang only allow the intrinsics of instruction sets that are not enabled by the build flags
+// in functions with a matching target attribute. MSVC allows all intrinsics in every function.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET(x) __attribute__((target(x)))
+#else
+#define TARGET(x)
+#endif
+
+using std::vector;
+
+namespace charls {
+namespace {
+
+#ifdef CHARLS_X86_KERNELS
+
+// Returns the number of 0 bits after the least significant 1 bit, value may not be 0.
+FORCE_INLINE int32_t CountTrailingZeros(const uint64_t value) noexcept
+{
+    ASSERT(value != 0);
+
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(value);
+#else
+    unsigned long index;
+    if (static_cast<uint32_t>(value) != 0)
+    {
+        _BitScanForward(&index, static_cast<uint32_t>(value));
+        return static_cast<int32_t>(index);
+    }
+
+    _BitScanForward(&index, static_cast<uint32_t>(value >> 32));
+    return 32 + static_cast<int32_t>(index);
+#endif
+}
+
+
+// The vector kernels compare a register of samples at once and use the compare mask to find the first
+// sample that is different. The remaining samples (less than one register) are compared one by one.
+template<typename T>
+int32_t CountEqualTail(const T* samples, const T value, int32_t index, const int32_t count) noexcept
+{
+    while (index < count && samples[index] == value)
+    {
+        ++index;
+    }
+
+    return index;
+}
+
+
+TARGET("sse2")
+int32_t CountEqual8Sse2(const uint8_t* samples, const uint8_t value, const int32_t count) noexcept
+{
+    const __m128i values = _mm_set1_epi8(static_cast<char>(value));
+
+    int32_t index = 0;
+    for (; index + 16 <= count; index += 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + index));
+        const auto notEqual = static_cast<uint32_t>(~_mm_movemask_epi8(_mm_cmpeq_epi8(block, values))) & 0xFFFFU;
+        if (notEqual != 0)
+            return index + CountTrailingZeros(notEqual);
+    }
+
+    return CountEqualTail(samples, value, index, count);
+}
+
+
+TARGET("sse2")
+int32_t CountEqual16Sse2(const uint16_t* samples, const uint16_t value, const int32_t count) noexcept
+{
+    const __m128i values = _mm_set1_epi16(static_cast<short>(value));
+
+    int32_t index = 0;
+    for (; index + 8 <= count; index += 8)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + index));
+        const auto notEqual = static_cast<uint32_t>(~_mm_movemask_epi8(_mm_cmpeq_epi16(block, values))) & 0xFFFFU;
+        if (notEqual != 0)
+            return index + CountTrailingZeros(notEqual) / 2; // the byte mask has 2 bits for every sample.
+    }
+
+    return CountEqualTail(samples, value, index, count);
+}
+
+
+TARGET("avx2")
+int32_t CountEqual8Avx2(const uint8_t* samples, const uint8_t value, const int32_t count) noexcept
+{
+    const __m256i values = _mm256_set1_epi8(static_cast<char>(value));
+
+    int32_t index = 0;
+    for (; index + 32 <= count; index += 32)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + index));
+        const auto notEqual = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, values)));
+        if (notEqual != 0)
+            return index + CountTrailingZeros(notEqual);
+    }
+
+    return CountEqualTail(samples, value, index, count);
+}
+
+
+TARGET("avx2")
+int32_t CountEqual16Avx2(const uint16_t* samples, const uint16_t value, const int32_t count) noexcept
+{
+    const __m256i values = _mm256_set1_epi16(static_cast<short>(value));
+
+    int32_t index = 0;
+    for (; index + 16 <= count; index += 16)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + index));
+        const auto notEqual = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(block, values)));
+        if (notEqual != 0)
+            return index + CountTrailingZeros(notEqual) / 2; // the byte mask has 2 bits for every sample.
+    }
+
+    return CountEqualTail(samples, value, index, count);
+}
+
+
+#ifdef CHARLS_AVX512_KERNELS
+TARGET("avx512f,avx512bw")
+int32_t CountEqual8Avx512(const uint8_t* samples, const uint8_t value, const int32_t count) noexcept
+{
+    const __m512i values = _mm512_set1_epi8(static_cast<char>(value));
+
+    int32_t index = 0;
+    for (; index + 64 <= count; index += 64)
+    {
+        const __m512i block = _mm512_loadu_si512(samples + index);
+        const uint64_t notEqual = ~static_cast<uint64_t>(_mm512_cmpeq_epi8_mask(block, values));
+        if (notEqual != 0)
+            return index + CountTrailingZeros(notEqual);
+    }
+
+    return CountEqualTail(samples, value, index, count);
+}
+
+
+TARGET("avx512f,avx512bw")
+int32_t CountEqual16Avx512(const uint16_t* samples, const uint16_t value, const int32_t count) noexcept
+{
+    const __m512i values = _mm512_set1_epi16(static_cast<short>(value));
+
+    int32_t index = 0;
+    for (; index + 32 <= count; index += 32)
+    {
+        const __m512i block = _mm512_loadu_si512(samples + index);
+        const uint32_t notEqual = ~_mm512_cmpeq_epi16_mask(block, values);
+        if (notEqual != 0)
+            return index + CountTrailingZeros(notEqual);
+    }
+
+    return CountEqualTail(samples, value, index, count);
+}
+#endif
+
+
+struct CpuFeatures final
+{
+    bool sse2;
+    bool avx2;
+    bool avx512bw;
+};
+
+
+// The AVX registers can only be used when the OS saves them on a context switch (checked with XGETBV).
+CpuFeatures DetectCpuFeatures() noexcept
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    const int highestFunction = info[0];
+
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    const uint64_t xcr0 = osxsave ? _xgetbv(0) : 0;
+    const bool osAvx = avx && (xcr0 & 0x6) == 0x6;
+    const bool osAvx512 = osAvx && (xcr0 & 0xE0) == 0xE0;
+
+    bool avx2 = false;
+    bool avx512bw = false;
+    if (highestFunction >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = osAvx && (info[1] & (1 << 5)) != 0;
+        avx512bw = osAvx512 && (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0;
+    }
+
+    return {sse2, avx2, avx512bw};
+#else
+    // The GCC builtins include the check for the OS support.
+    __builtin_cpu_init();
+    return {__builtin_cpu_supports("sse2") != 0, __builtin_cpu_supports("avx2") != 0,
+            __builtin_cpu_supports("avx512f") != 0 && __builtin_cpu_supports("avx512bw") != 0};
+#endif
+}
+
+#endif
+
+
+constexpr CodecKernels GenericKernels{"generic", CountEqualPixels<uint8_t>, CountEqualPixels<uint16_t>};
+
+#ifdef CHARLS_X86_KERNELS
+constexpr CodecKernels Sse2Kernels{"sse2", CountEqual8Sse2, CountEqual16Sse2};
+constexpr CodecKernels Avx2Kernels{"avx2", CountEqual8Avx2, CountEqual16Avx2};
+#ifdef CHARLS_AVX512_KERNELS
+constexpr CodecKernels Avx512Kernels{"avx512bw", CountEqual8Avx512, CountEqual16Avx512};
+#endif
+#endif
+
+} // namespace
+
+
+vector<const CodecKernels*> GetSupportedCodecKernels()
+{
+    vector<const CodecKernels*> kernels{&GenericKernels};
+
+#ifdef CHARLS_X86_KERNELS
+    const CpuFeatures features{DetectCpuFeatures()};
+    if (features.sse2)
+    {
+        kernels.push_back(&Sse2Kernels);
+    }
+
+    if (features.avx2)
+    {
+        kernels.push_back(&Avx2Kernels);
+    }
+
+#ifdef CHARLS_AVX512_KERNELS
+    if (features.avx512bw)
+    {
+        kernels.push_back(&Avx512Kernels);
+    }
+#endif
+#endif
+
+    return kernels;
+}
+
+
+// The selection is a function local static: C++11 guarantees a thread safe initialization on first use.
+const CodecKernels& GetCodecKernels()
+{
+    static const CodecKernels& kernels{*GetSupportedCodecKernels().back()};
+    return kernels;
+}
+
+} // namespace charls
+
+
+extern "C" {
+
+const char* CHARLS_API_CALLING_CONVENTION charls_get_cpu_dispatch_path() noexcept
+{
+    try
+    {
+        return charls::GetCodecKernels().name;
+    }
+    catch (...)
+    {
+        return charls::GenericKernels.name;
+    }
+}
+
+}
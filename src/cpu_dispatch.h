@@ -0,0 +1,79 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace charls {
+
+// Purpose: the codec kernels that have CPU specific implementations. The kernels are selected once, based on
+// the instruction sets the CPU (and the OS) supports, this allows one build of the library to use the vector
+// instructions of the CPU it runs on.
+struct CodecKernels final
+{
+    const char* name;
+
+    // Returns the number of samples, from the start, that are equal to value.
+    int32_t (*countEqual8)(const uint8_t* samples, uint8_t value, int32_t count);
+    int32_t (*countEqual16)(const uint16_t* samples, uint16_t value, int32_t count);
+};
+
+
+// Returns the kernels for the CPU that runs the library, the same kernels are used by all codecs.
+const CodecKernels& GetCodecKernels();
+
+// Returns all kernel implementations the CPU supports, ordered from generic to most specific.
+std::vector<const CodecKernels*> GetSupportedCodecKernels();
+
+
+// Generic implementation: the pixels are compared in blocks without an early exit inside the block,
+// which allows the compiler to vectorize the comparisons for the instruction set of the build.
+template<typename PIXEL>
+int32_t CountEqualPixels(const PIXEL* pixels, const PIXEL value, const int32_t count) noexcept
+{
+    constexpr int32_t blockSize = 16;
+
+    int32_t equalCount = 0;
+    while (equalCount + blockSize <= count)
+    {
+        bool allEqual = true;
+        for (int32_t i = 0; i < blockSize; ++i)
+        {
+            allEqual &= pixels[equalCount + i] == value;
+        }
+
+        if (!allEqual)
+            break;
+
+        equalCount += blockSize;
+    }
+
+    while (equalCount < count && pixels[equalCount] == value)
+    {
+        ++equalCount;
+    }
+
+    return equalCount;
+}
+
+
+// 8 and 16 bit samples are compared with the CPU specific kernel, other pixel types with the generic implementation.
+template<typename PIXEL>
+int32_t CountEqualPixels(const CodecKernels&, const PIXEL* pixels, const PIXEL value, const int32_t count) noexcept
+{
+    return CountEqualPixels(pixels, value, count);
+}
+
+inline int32_t CountEqualPixels(const CodecKernels& kernels, const uint8_t* samples, const uint8_t value, const int32_t count)
+{
+    return kernels.countEqual8(samples, value, count);
+}
+
+inline int32_t CountEqualPixels(const CodecKernels& kernels, const uint16_t* samples, const uint16_t value, const int32_t count)
+{
+    return kernels.countEqual16(samples, value, count);
+}
+
+} // namespace charls
@@ -6,17 +6,24 @@
 #include <charls/jpegls_error.h>
 
 #include "util.h"
+#include "coding_statistics.h"
 #include "process_line.h"
 #include "jpeg_marker_code.h"
+#include "row_index.h"
+#include "trace.h"
 
 #include <memory>
 #include <cassert>
+#include <cstring>
 
 namespace charls {
 
 // Purpose: Implements encoding to stream of bits. In encoding mode JpegLsCodec inherits from EncoderStrategy
 class DecoderStrategy
 {
+    using bufType = std::size_t;
+    static constexpr auto bufType_bit_count = static_cast<int32_t>(sizeof(bufType) * 8);
+
 public:
     explicit DecoderStrategy(const JlsParameters& params) :
         params_{params}
@@ -33,6 +40,22 @@ class DecoderStrategy
     virtual std::unique_ptr<ProcessLine> CreateProcess(ByteStreamInfo rawStreamInfo) = 0;
     virtual void SetPresets(const jpegls_pc_parameters& preset_coding_parameters) = 0;
     virtual void DecodeScan(std::unique_ptr<ProcessLine> outputData, const JlsRect& size, ByteStreamInfo& compressedData) = 0;
+    virtual void ResumeScan(ByteStreamInfo& compressedData) = 0;
+    virtual void DecodeScan(std::unique_ptr<ProcessLine> outputData, const JlsRect& size, ByteStreamInfo& compressedData, const ScanCheckpoint& checkpoint) = 0;
+
+    // A partial source only contains the first part of the encoded data: when the data runs out need_more_data is
+    // thrown and the scan can be resumed (at the start of the line that was being decoded) after more data has been received.
+    void SetPartialSource(bool value) noexcept
+    {
+        partialSource_ = value;
+    }
+
+    // While checkpoints are recorded, the coding state is added to the checkpoints every rowInterval lines.
+    void RecordCheckpoints(std::vector<ScanCheckpoint>* checkpoints, uint32_t rowInterval) noexcept
+    {
+        recordedCheckpoints_ = checkpoints;
+        checkpointInterval_ = rowInterval;
+    }
 
     void Init(ByteStreamInfo& compressedStream)
     {
@@ -54,8 +77,30 @@ class DecoderStrategy
             endPosition_ = position_ + compressedStream.count;
         }
 
+        startPosition_ = position_;
+        nextFFPosition_ = FindNextFF();
+
+        // A partial source is only read when bits are needed, to report missing data during the first line.
+        if (!partialSource_)
+        {
+            MakeValid();
+        }
+    }
+
+    BitReaderState GetBitReaderState() const noexcept
+    {
+        return {static_cast<std::size_t>(position_ - startPosition_), readCache_, validBits_};
+    }
+
+    // Continues reading at a saved state, the compressed data may have been moved and extended since the state was saved.
+    void RestoreBitReaderState(const ByteStreamInfo& compressedStream, const BitReaderState& state) noexcept
+    {
+        startPosition_ = compressedStream.rawData;
+        position_ = startPosition_ + state.position;
+        endPosition_ = startPosition_ + compressedStream.count;
+        readCache_ = state.readCache;
+        validBits_ = state.validBits;
         nextFFPosition_ = FindNextFF();
-        MakeValid();
     }
 
     void AddBytesFromStream()
@@ -77,6 +122,7 @@ class DecoderStrategy
         position_ += offset;
         endPosition_ += offset;
         nextFFPosition_ += offset;
+        COUNT_EVENT(lineStartPosition_ += offset);
 
         const std::streamsize readBytes = byteStream_->sgetn(reinterpret_cast<char*>(endPosition_),
             static_cast<std::streamsize>(buffer_.size()) - count);
@@ -89,17 +135,56 @@ class DecoderStrategy
         readCache_ = readCache_ << length;
     }
 
-    static void OnLineBegin(int32_t /*cpixel*/, void* /*ptypeBuffer*/, int32_t /*pixelStride*/) noexcept
+    static void OnLineBegin(int32_t /*cpixel*/, void* /*ptypeBuffer*/, int32_t /*pixelStride*/, int32_t /*line*/) noexcept
     {
     }
 
-    void OnLineEnd(int32_t pixelCount, const void* ptypeBuffer, int32_t pixelStride) const
+    void OnLineEnd(int32_t pixelCount, const void* ptypeBuffer, int32_t pixelStride, int32_t line) const
     {
+        const TraceSpan span{tracer_, trace_event::process_line, static_cast<uint32_t>(line)};
         processLine_->NewLineDecoded(ptypeBuffer, pixelCount, pixelStride);
     }
 
+    void SetTracer(const Tracer& tracer) noexcept
+    {
+        tracer_ = tracer;
+    }
+
+    void SetRestartInterval(uint32_t restartInterval) noexcept
+    {
+        restartInterval_ = restartInterval;
+    }
+
+    // Completes the current restart interval: verifies that all bits are consumed, reads the
+    // RSTm marker and restarts the bit stream (see ISO/IEC 14495-1, C.2.5 and T.81, E.2.4).
+    void OnRestartMarker(int32_t restartMarkerIndex)
+    {
+        EndScan();
+
+        if (ReadByte() != JpegMarkerStartByte)
+            throw jpegls_error{jpegls_errc::restart_marker_not_found};
+
+        // Read all preceding 0xFF fill values until a non 0xFF value has been found. (see T.81, B.1.1.2)
+        uint8_t value;
+        do
+        {
+            value = ReadByte();
+        } while (value == JpegMarkerStartByte);
+
+        if (value != JpegRestartMarkerBase + restartMarkerIndex)
+            throw jpegls_error{jpegls_errc::restart_marker_not_found};
+
+        validBits_ = 0;
+        readCache_ = 0;
+        nextFFPosition_ = FindNextFF();
+        MakeValid();
+    }
+
     void EndScan()
     {
+        if (partialSource_ && position_ == endPosition_)
+            throw jpegls_error{jpegls_errc::need_more_data};
+
         if (*position_ != JpegMarkerStartByte)
         {
             ReadBit();
@@ -112,6 +197,20 @@ class DecoderStrategy
             throw jpegls_error{jpegls_errc::too_much_encoded_data};
     }
 
+    uint8_t ReadByte()
+    {
+        if (position_ == endPosition_)
+        {
+            AddBytesFromStream();
+            if (position_ == endPosition_)
+                throw jpegls_error{partialSource_ ? jpegls_errc::need_more_data : jpegls_errc::source_buffer_too_small};
+        }
+
+        const uint8_t value = *position_;
+        position_++;
+        return value;
+    }
+
     FORCE_INLINE bool OptimizedRead() noexcept
     {
         // Easy & fast: if there is no 0xFF byte in sight, we can read without bit stuffing
@@ -130,16 +229,21 @@ class DecoderStrategy
     void MakeValid()
     {
         ASSERT(validBits_ <= bufType_bit_count - 8);
+        COUNT_EVENT(++statistics_.bit_reader_fill_count);
 
         if (OptimizedRead())
             return;
 
+        COUNT_EVENT(++statistics_.bit_reader_slow_fill_count);
         AddBytesFromStream();
 
         do
         {
             if (position_ >= endPosition_)
             {
+                if (partialSource_)
+                    throw jpegls_error{jpegls_errc::need_more_data};
+
                 if (validBits_ <= 0)
                     throw jpegls_error{jpegls_errc::invalid_encoded_data};
 
@@ -151,6 +255,9 @@ class DecoderStrategy
             if (valueNew == JpegMarkerStartByte)
             {
                 // JPEG bit stream rule: no FF may be followed by 0x80 or higher
+                if (partialSource_ && position_ == endPosition_ - 1)
+                    throw jpegls_error{jpegls_errc::need_more_data};
+
                 if (position_ == endPosition_ - 1 || (position_[1] & 0x80) != 0)
                 {
                     if (validBits_ <= 0)
@@ -167,26 +274,26 @@ class DecoderStrategy
             if (valueNew == JpegMarkerStartByte)
             {
                 validBits_--;
+                COUNT_EVENT(++statistics_.stuffed_byte_count);
             }
         }
         while (validBits_ < bufType_bit_count - 8);
 
-        nextFFPosition_ = FindNextFF();
+        // The found 0xFF byte remains the next one until it has been read: only search again after that.
+        if (position_ > nextFFPosition_ || nextFFPosition_ == endPosition_)
+        {
+            nextFFPosition_ = FindNextFF();
+        }
     }
 
     uint8_t* FindNextFF() const noexcept
     {
-        auto positionNextFF = position_;
-
-        while (positionNextFF < endPosition_)
-        {
-            if (*positionNextFF == JpegMarkerStartByte)
-                break;
+        if (position_ == endPosition_)
+            return position_;
 
-            positionNextFF++;
-        }
-
-        return positionNextFF;
+        // memchr is implemented with vector instructions by the C runtime libraries.
+        auto* positionNextFF = static_cast<uint8_t*>(std::memchr(position_, JpegMarkerStartByte, static_cast<std::size_t>(endPosition_ - position_)));
+        return positionNextFF ? positionNextFF : endPosition_;
     }
 
     uint8_t* GetCurBytePos() const noexcept
@@ -222,14 +329,15 @@ class DecoderStrategy
         return result;
     }
 
-    FORCE_INLINE int32_t PeekByte()
+    FORCE_INLINE int32_t PeekBits(const int32_t bitCount)
     {
-        if (validBits_ < 8)
+        ASSERT(bitCount > 0 && bitCount <= bufType_bit_count - 8);
+        if (validBits_ < bitCount)
         {
             MakeValid();
         }
 
-        return static_cast<int32_t>(readCache_ >> (bufType_bit_count - 8));
+        return static_cast<int32_t>(readCache_ >> (bufType_bit_count - bitCount));
     }
 
     FORCE_INLINE bool ReadBit()
@@ -244,39 +352,63 @@ class DecoderStrategy
         return bSet;
     }
 
-    FORCE_INLINE int32_t Peek0Bits()
+    // Reads the unary coded high bits: the number of 0 bits before the next 1 bit.
+    FORCE_INLINE int32_t ReadHighBits()
     {
         if (validBits_ < 16)
         {
             MakeValid();
         }
-        bufType valTest = readCache_;
 
-        for (int32_t count = 0; count < 16; count++)
+        // Note: the bits after the valid bits are 0 or the next bits of the stream.
+        if (readCache_ != 0)
         {
-            if ((valTest & (static_cast<bufType>(1) << (bufType_bit_count - 1))) != 0)
+            const int32_t count = CountLeadingZeros(readCache_);
+            if (count < validBits_)
+            {
+                Skip(count + 1);
                 return count;
-
-            valTest <<= 1;
+            }
         }
-        return -1;
+
+        return ReadLongHighBits();
     }
 
-    FORCE_INLINE int32_t ReadHighBits()
+    int32_t ReadLongHighBits()
     {
-        const int32_t count = Peek0Bits();
-        if (count >= 0)
+        // All valid bits of the cache are 0, drop them and continue with the next bits of the stream.
+        int32_t highBitsCount = 0;
+        for (;;)
         {
-            Skip(count + 1);
-            return count;
+            highBitsCount += validBits_;
+            readCache_ = 0;
+            validBits_ = 0;
+            MakeValid();
+
+            if (readCache_ != 0)
+            {
+                const int32_t count = CountLeadingZeros(readCache_);
+                if (count < validBits_)
+                {
+                    Skip(count + 1);
+                    return highBitsCount + count;
+                }
+            }
         }
-        Skip(15);
+    }
 
-        for (int32_t highBitsCount = 15; ; highBitsCount++)
+    // Returns the number of consecutive 1 bits at the current position, without consuming them.
+    // The count is limited to the valid bits of the cache (and less than the cache size to allow skipping them).
+    FORCE_INLINE int32_t PeekLeadingOnes()
+    {
+        if (validBits_ < 16)
         {
-            if (ReadBit())
-                return highBitsCount;
+            MakeValid();
         }
+
+        const bufType invertedCache = ~readCache_;
+        const int32_t count = invertedCache == 0 ? bufType_bit_count - 1 : CountLeadingZeros(invertedCache);
+        return std::min(count, validBits_);
     }
 
     int32_t ReadLongValue(int32_t length)
@@ -287,23 +419,59 @@ class DecoderStrategy
         return (ReadValue(length - 24) << 24) + ReadValue(24);
     }
 
+#ifdef CHARLS_ENABLE_STATISTICS
+    const coding_statistics& Statistics() const noexcept
+    {
+        return statistics_;
+    }
+
+    void ResetStatistics() noexcept
+    {
+        statistics_ = {};
+    }
+
+    void BeginLineStatistics() noexcept
+    {
+        lineStartPosition_ = position_;
+        lineStartValidBits_ = validBits_;
+    }
+
+    // Adds the line that has been decoded since BeginLineStatistics, its size is the number of consumed bits.
+    void EndLineStatistics() noexcept
+    {
+        const auto bitCount = (position_ - lineStartPosition_) * 8 + lineStartValidBits_ - validBits_;
+        AddLine(statistics_, static_cast<uint64_t>(bitCount));
+    }
+#endif
+
 protected:
     JlsParameters params_;
     std::unique_ptr<ProcessLine> processLine_;
+    uint32_t restartInterval_{};
+    bool partialSource_{};
+    std::vector<ScanCheckpoint>* recordedCheckpoints_{};
+    uint32_t checkpointInterval_{};
+    Tracer tracer_{};
+#ifdef CHARLS_ENABLE_STATISTICS
+    coding_statistics statistics_{};
+#endif
 
 private:
-    using bufType = std::size_t;
-    static constexpr auto bufType_bit_count = static_cast<int32_t>(sizeof(bufType) * 8);
-
     std::vector<uint8_t> buffer_;
     std::basic_streambuf<char>* byteStream_{};
 
     // decoding
     bufType readCache_{};
     int32_t validBits_{};
+    uint8_t* startPosition_{};
     uint8_t* position_{};
     uint8_t* nextFFPosition_{};
     uint8_t* endPosition_{};
+
+#ifdef CHARLS_ENABLE_STATISTICS
+    uint8_t* lineStartPosition_{};
+    int32_t lineStartValidBits_{};
+#endif
 };
 
 } // namespace charls
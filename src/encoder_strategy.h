@@ -5,6 +5,7 @@
 
 #include "decoder_strategy.h"
 #include "process_line.h"
+#include "trace.h"
 
 namespace charls {
 
@@ -30,20 +31,77 @@ class EncoderStrategy
 
     int32_t PeekByte();
 
-    void OnLineBegin(int32_t cpixel, void* ptypeBuffer, int32_t pixelStride) const
+    void OnLineBegin(int32_t cpixel, void* ptypeBuffer, int32_t pixelStride, int32_t line) const
     {
+        const TraceSpan span{tracer_, trace_event::process_line, static_cast<uint32_t>(line)};
         processLine_->NewLineRequested(ptypeBuffer, cpixel, pixelStride);
     }
 
-    static void OnLineEnd(int32_t /*cpixel*/, void* /*ptypeBuffer*/, int32_t /*pixelStride*/) noexcept
+    static void OnLineEnd(int32_t /*cpixel*/, void* /*ptypeBuffer*/, int32_t /*pixelStride*/, int32_t /*line*/) noexcept
     {
     }
 
+    void SetTracer(const Tracer& tracer) noexcept
+    {
+        tracer_ = tracer;
+    }
+
+    void SetRestartInterval(uint32_t restartInterval) noexcept
+    {
+        restartInterval_ = restartInterval;
+    }
+
+    // The legacy stream API passes 16 bit samples with swapped bytes, the rows of a strip source are in the native byte order.
+    void SetNativeByteOrderStream(const bool value) noexcept
+    {
+        nativeByteOrderStream_ = value;
+    }
+
+    // Completes the current restart interval: pads the bit stream to a byte boundary,
+    // writes the RSTm marker and restarts the bit stream (see ISO/IEC 14495-1, C.2.5 and T.81, E.1.4).
+    void OnRestartMarker(int32_t restartMarkerIndex)
+    {
+        FlushToByteBoundary();
+
+        WriteByte(JpegMarkerStartByte);
+        WriteByte(static_cast<uint8_t>(JpegRestartMarkerBase + restartMarkerIndex));
+
+        bitBuffer_ = 0;
+        freeBitCount_ = bitBuffer_bit_count;
+        isFFWritten_ = false;
+    }
+
+#ifdef CHARLS_ENABLE_STATISTICS
+    const coding_statistics& Statistics() const noexcept
+    {
+        return statistics_;
+    }
+
+    void ResetStatistics() noexcept
+    {
+        statistics_ = {};
+    }
+
+    void BeginLineStatistics() noexcept
+    {
+        lineStartBitCount_ = GetBitCount();
+    }
+
+    // Adds the line that has been encoded since BeginLineStatistics, its size is the number of appended bits.
+    void EndLineStatistics() noexcept
+    {
+        AddLine(statistics_, GetBitCount() - lineStartBitCount_);
+    }
+#endif
+
 protected:
     void Init(ByteStreamInfo& compressedStream)
     {
-        freeBitCount_ = sizeof(bitBuffer_) * 8;
+        freeBitCount_ = bitBuffer_bit_count;
         bitBuffer_ = 0;
+        isFFWritten_ = false;
+        bytesWritten_ = 0;
+        compressedStream_ = nullptr;
 
         if (compressedStream.rawStream)
         {
@@ -68,30 +126,31 @@ class EncoderStrategy
         ASSERT((bits | mask) == mask); // Not used bits must be set to zero.
 #endif
 
+        // Note: the complete bytes are flushed when 32 or less bits are free, there is always room for 31 new bits.
         freeBitCount_ -= bitCount;
-        if (freeBitCount_ >= 0)
+        ASSERT(freeBitCount_ >= 0 && freeBitCount_ <= bitBuffer_bit_count);
+
+        // Shift in 2 steps: the free bit count is 64 when 0 bits are appended to an empty buffer.
+        bitBuffer_ |= (static_cast<bitBufferType>(bits) << 1U) << (freeBitCount_ - 1);
+
+        if (freeBitCount_ <= 32)
         {
-            bitBuffer_ |= bits << freeBitCount_;
+            FlushCompleteBytes();
         }
-        else
-        {
-            // Add as much bits in the remaining space as possible and flush.
-            bitBuffer_ |= bits >> -freeBitCount_;
-            Flush();
+    }
 
-            // A second flush may be required if extra marker detect bits were needed and not all bits could be written.
-            if (freeBitCount_ < 0)
-            {
-                bitBuffer_ |= bits >> -freeBitCount_;
-                Flush();
-            }
+    void EndScan()
+    {
+        const TraceSpan span{tracer_, trace_event::flush};
+        FlushToByteBoundary();
 
-            ASSERT(freeBitCount_ >= 0);
-            bitBuffer_ |= bits << freeBitCount_;
+        if (compressedStream_)
+        {
+            OverFlow();
         }
     }
 
-    void EndScan()
+    void FlushToByteBoundary()
     {
         Flush();
 
@@ -102,12 +161,20 @@ class EncoderStrategy
             AppendToBitStream(0, freeBitCount_ % 8);
 
         Flush();
-        ASSERT(freeBitCount_ == 0x20);
+        ASSERT(freeBitCount_ == bitBuffer_bit_count);
+    }
 
-        if (compressedStream_)
+    void WriteByte(uint8_t value)
+    {
+        if (compressedLength_ == 0)
         {
             OverFlow();
         }
+
+        *position_ = value;
+        position_++;
+        compressedLength_--;
+        bytesWritten_++;
     }
 
     void OverFlow()
@@ -125,42 +192,74 @@ class EncoderStrategy
         compressedLength_ = buffer_.size();
     }
 
+    // Writes all bits in the bit buffer, the last byte is padded with 0 bits when not complete.
     void Flush()
     {
-        if (compressedLength_ < 4)
+        while (freeBitCount_ < bitBuffer_bit_count)
         {
-            OverFlow();
+            WriteBitBufferByte();
         }
+    }
 
-        for (int i = 0; i < 4; ++i)
+    // Writes the complete bytes of the bit buffer: 8 bytes at once when no 0xFF byte is present,
+    // otherwise byte by byte to insert the 0 bit after every 0xFF byte.
+    void FlushCompleteBytes()
+    {
+        if (!isFFWritten_ && compressedLength_ >= sizeof(bitBuffer_) && !HasFFByte(bitBuffer_))
         {
-            if (freeBitCount_ >= 32)
-                break;
-
-            if (isFFWritten_)
+            // Write all bytes of the buffer, but only count the complete bytes: the others are overwritten by the next flush.
+            for (size_t i = 0; i < sizeof(bitBuffer_); ++i)
             {
-                // JPEG-LS requirement (T.87, A.1) to detect markers: after a xFF value a single 0 bit needs to be inserted.
-                *position_ = static_cast<uint8_t>(bitBuffer_ >> 25);
-                bitBuffer_ = bitBuffer_ << 7;
-                freeBitCount_ += 7;
-            }
-            else
-            {
-                *position_ = static_cast<uint8_t>(bitBuffer_ >> 24);
-                bitBuffer_ = bitBuffer_ << 8;
-                freeBitCount_ += 8;
+                position_[i] = static_cast<uint8_t>(bitBuffer_ >> (bitBuffer_bit_count - 8 - 8 * i));
             }
 
-            isFFWritten_ = *position_ == JpegMarkerStartByte;
-            position_++;
-            compressedLength_--;
-            bytesWritten_++;
+            const int32_t byteCount = (bitBuffer_bit_count - freeBitCount_) / 8;
+            ASSERT(byteCount < static_cast<int32_t>(sizeof(bitBuffer_)));
+            position_ += byteCount;
+            compressedLength_ -= byteCount;
+            bytesWritten_ += byteCount;
+            bitBuffer_ <<= 8 * byteCount;
+            freeBitCount_ += 8 * byteCount;
+            return;
+        }
+
+        while (freeBitCount_ <= bitBuffer_bit_count - (isFFWritten_ ? 7 : 8))
+        {
+            WriteBitBufferByte();
         }
     }
 
+    void WriteBitBufferByte()
+    {
+        uint8_t value;
+        if (isFFWritten_)
+        {
+            // JPEG-LS requirement (T.87, A.1) to detect markers: after a xFF value a single 0 bit needs to be inserted.
+            value = static_cast<uint8_t>(bitBuffer_ >> (bitBuffer_bit_count - 7));
+            bitBuffer_ <<= 7;
+            freeBitCount_ += 7;
+        }
+        else
+        {
+            value = static_cast<uint8_t>(bitBuffer_ >> (bitBuffer_bit_count - 8));
+            bitBuffer_ <<= 8;
+            freeBitCount_ += 8;
+        }
+
+        WriteByte(value);
+        isFFWritten_ = value == JpegMarkerStartByte;
+        COUNT_EVENT(statistics_.stuffed_byte_count += isFFWritten_ ? 1 : 0);
+    }
+
+    // Returns true when one of the bytes of value is 0xFF (the same byte of ~value is then 0).
+    static constexpr bool HasFFByte(const uint64_t value) noexcept
+    {
+        return ((~value - 0x0101010101010101U) & value & 0x8080808080808080U) != 0;
+    }
+
     std::size_t GetLength() const noexcept
     {
-        return bytesWritten_ - (freeBitCount_ - 32) / 8;
+        return bytesWritten_ - (freeBitCount_ - bitBuffer_bit_count) / 8;
     }
 
     FORCE_INLINE void AppendOnesToBitStream(int32_t length)
@@ -171,10 +270,19 @@ class EncoderStrategy
     std::unique_ptr<DecoderStrategy> decoder_;
     JlsParameters params_;
     std::unique_ptr<ProcessLine> processLine_;
+    uint32_t restartInterval_{};
+    bool nativeByteOrderStream_{};
+    Tracer tracer_{};
+#ifdef CHARLS_ENABLE_STATISTICS
+    coding_statistics statistics_{};
+#endif
 
 private:
-    unsigned int bitBuffer_{};
-    int32_t freeBitCount_{sizeof bitBuffer_ * 8};
+    using bitBufferType = uint64_t;
+    static constexpr int32_t bitBuffer_bit_count = static_cast<int32_t>(sizeof(bitBufferType) * 8);
+
+    bitBufferType bitBuffer_{};
+    int32_t freeBitCount_{bitBuffer_bit_count};
     std::size_t compressedLength_{};
 
     // encoding
@@ -184,6 +292,16 @@ class EncoderStrategy
 
     std::vector<uint8_t> buffer_;
     std::basic_streambuf<char>* compressedStream_{};
+
+#ifdef CHARLS_ENABLE_STATISTICS
+    // Returns the number of bits written to the destination and the bit buffer.
+    std::size_t GetBitCount() const noexcept
+    {
+        return bytesWritten_ * 8 + static_cast<std::size_t>(bitBuffer_bit_count - freeBitCount_);
+    }
+
+    std::size_t lineStartBitCount_{};
+#endif
 };
 
 } // namespace charls
@@ -5,9 +5,10 @@
 
 #include <charls/public_types.h>
 
-#include <memory>
+#include "coding_statistics.h"
+#include "trace.h"
 
-struct JlsParameters;
+#include <memory>
 
 namespace charls {
 
@@ -21,4 +22,69 @@ class JlsCodecFactory final
     std::unique_ptr<Strategy> CreateOptimizedCodec(const JlsParameters& params);
 };
 
+// Purpose: keeps the last created codec alive. When the next scan has the same coding parameters the codec,
+// including its allocated line buffers and lookup tables, is reused instead of creating a new one.
+template<typename Strategy>
+class CodecCache final
+{
+public:
+    Strategy& GetCodec(const JlsParameters& params, const jpegls_pc_parameters& preset_coding_parameters, const Tracer& tracer)
+    {
+        if (!codec_ || !HasSameCodingParameters(params_, params) || !HasSamePresets(presets_, preset_coding_parameters))
+        {
+            COUNT_EVENT(if (codec_) MergeStatistics(retiredStatistics_, codec_->Statistics()));
+            const TraceSpan span{tracer, trace_event::create_codec};
+            codec_ = JlsCodecFactory<Strategy>().CreateCodec(params, preset_coding_parameters);
+            params_ = params;
+            presets_ = preset_coding_parameters;
+        }
+
+        codec_->SetTracer(tracer);
+        return *codec_;
+    }
+
+#ifdef CHARLS_ENABLE_STATISTICS
+    // Adds the statistics of the current codec and of the codecs it replaced.
+    void AddStatistics(coding_statistics& total) const noexcept
+    {
+        MergeStatistics(total, retiredStatistics_);
+        if (codec_)
+        {
+            MergeStatistics(total, codec_->Statistics());
+        }
+    }
+
+    void ResetStatistics() noexcept
+    {
+        retiredStatistics_ = {};
+        if (codec_)
+        {
+            codec_->ResetStatistics();
+        }
+    }
+#endif
+
+private:
+    static bool HasSameCodingParameters(const JlsParameters& a, const JlsParameters& b) noexcept
+    {
+        return a.width == b.width && a.height == b.height && a.bitsPerSample == b.bitsPerSample &&
+               a.stride == b.stride && a.components == b.components && a.allowedLossyError == b.allowedLossyError &&
+               a.interleaveMode == b.interleaveMode && a.colorTransformation == b.colorTransformation &&
+               a.outputBgr == b.outputBgr;
+    }
+
+    static bool HasSamePresets(const jpegls_pc_parameters& a, const jpegls_pc_parameters& b) noexcept
+    {
+        return a.maximum_sample_value == b.maximum_sample_value && a.threshold1 == b.threshold1 &&
+               a.threshold2 == b.threshold2 && a.threshold3 == b.threshold3 && a.reset_value == b.reset_value;
+    }
+
+    std::unique_ptr<Strategy> codec_;
+    JlsParameters params_{};
+    jpegls_pc_parameters presets_{};
+#ifdef CHARLS_ENABLE_STATISTICS
+    coding_statistics retiredStatistics_{};
+#endif
+};
+
 } // namespace charls
@@ -17,11 +17,16 @@ namespace charls {
 
 constexpr uint8_t JpegMarkerStartByte = 0xFF;
 
+// Restart markers are RST0 - RST7 (0xD0 - 0xD7), the index m of RSTm cycles modulo 8 (see T.81, B.2.1).
+constexpr uint8_t JpegRestartMarkerBase = 0xD0;
+constexpr int32_t JpegRestartMarkerRange = 8;
+
 enum class JpegMarkerCode : uint8_t
 {
-    StartOfImage = 0xD8, // SOI: Marks the start of an image.
-    EndOfImage = 0xD9,   // EOI: Marks the end of an image.
-    StartOfScan = 0xDA,  // SOS: Marks the start of scan.
+    StartOfImage = 0xD8,          // SOI: Marks the start of an image.
+    EndOfImage = 0xD9,            // EOI: Marks the end of an image.
+    StartOfScan = 0xDA,           // SOS: Marks the start of scan.
+    DefineRestartInterval = 0xDD, // DRI: Defines the restart interval used in succeeding scans.
 
     // The following markers are defined in ISO/IEC 10918-1 | ITU T.81.
     StartOfFrameBaselineJpeg = 0xC0,            // SOF_0:  Marks the start of a baseline jpeg encoded frame.
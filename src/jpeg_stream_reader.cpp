@@ -9,11 +9,13 @@
 #include "jls_codec_factory.h"
 #include "jpeg_marker_code.h"
 #include "jpegls_preset_parameters_type.h"
+#include "parallel_for.h"
 #include "util.h"
 
 #include <algorithm>
 #include <iomanip>
 #include <memory>
+#include <utility>
 
 using std::find;
 using std::vector;
@@ -37,19 +39,107 @@ void CheckParameterCoherent(const JlsParameters& params)
     }
 }
 
+
+// Returns the position of the marker code of the next marker or end when there is none.
+// In the encoded bit stream a 0xFF byte is always followed by a value < 0x80 (bit stuffing), a value >= 0x80 can only be a marker.
+uint8_t* FindNextMarkerCode(uint8_t* position, uint8_t* const end) noexcept
+{
+    for (;;)
+    {
+        position = find(position, end, JpegMarkerStartByte);
+        do
+        {
+            ++position;
+        } while (position < end && *position == JpegMarkerStartByte); // Skip optional fill bytes (T.81, B.1.1.2)
+
+        if (position >= end)
+            return end;
+
+        if (*position >= 0x80)
+            return position;
+    }
+}
+
+
+bool IsRestartMarkerCode(const uint8_t markerCode) noexcept
+{
+    return markerCode >= JpegRestartMarkerBase && markerCode < JpegRestartMarkerBase + JpegRestartMarkerRange;
+}
+
 } // namespace
 
 namespace charls {
 
 JpegStreamReader::JpegStreamReader(ByteStreamInfo byteStreamInfo) noexcept :
-    byteStream_{byteStreamInfo}
+    byteStream_{byteStreamInfo},
+    sourceStart_{byteStreamInfo.rawData}
+{
+}
+
+
+JpegStreamReader::~JpegStreamReader() = default;
+
+
+void JpegStreamReader::Reset(const ByteStreamInfo byteStreamInfo) noexcept
+{
+    byteStream_ = byteStreamInfo;
+    sourceStart_ = byteStreamInfo.rawData;
+    partialSource_ = false;
+    scanSuspended_ = false;
+    componentIndex_ = 0;
+    params_ = {};
+    preset_coding_parameters_ = {};
+    rect_ = {};
+    restartInterval_ = 0;
+    componentIds_.clear();
+    state_ = state::before_start_of_image;
+}
+
+
+void JpegStreamReader::ExtendSource(const ByteStreamInfo byteStreamInfo) noexcept
+{
+    ASSERT(partialSource_ && byteStream_.rawData);
+
+    const auto position = static_cast<size_t>(byteStream_.rawData - sourceStart_);
+    sourceStart_ = byteStreamInfo.rawData;
+    byteStream_ = {nullptr, byteStreamInfo.rawData + position, byteStreamInfo.count - position};
+}
+
+
+#ifdef CHARLS_ENABLE_STATISTICS
+void JpegStreamReader::AddStatistics(coding_statistics& total) const noexcept
+{
+    for (const auto& codec : codecs_)
+    {
+        codec.AddStatistics(total);
+    }
+}
+
+
+void JpegStreamReader::ResetStatistics() noexcept
+{
+    for (auto& codec : codecs_)
+    {
+        codec.ResetStatistics();
+    }
+}
+#endif
+
+
+// Note: the caller must ensure that the codec cache has been created before index is accessed concurrently.
+// The cached codecs are reused across decodes, the partial source mode is set on every use to not keep a stale mode.
+DecoderStrategy& JpegStreamReader::GetCodec(const size_t index, const JlsParameters& params)
 {
+    ASSERT(index < codecs_.size());
+    DecoderStrategy& codec = codecs_[index].GetCodec(params, preset_coding_parameters_, tracer_);
+    codec.SetPartialSource(partialSource_);
+    return codec;
 }
 
 
 void JpegStreamReader::Read(ByteStreamInfo rawPixels)
 {
-    ASSERT(state_ == state::bit_stream_section);
+    ASSERT(state_ == state::bit_stream_section || (partialSource_ && state_ == state::scan_section));
 
     CheckParameterCoherent(params_);
 
@@ -64,28 +154,270 @@ void JpegStreamReader::Read(ByteStreamInfo rawPixels)
     if (rawPixels.rawData && static_cast<int64_t>(rawPixels.count) < bytesPerPlane * params_.components)
         throw jpegls_error{jpegls_errc::destination_buffer_too_small};
 
-    int componentIndex{};
-    while (componentIndex < params_.components)
+    if (codecs_.empty())
+    {
+        codecs_.resize(1);
+    }
+
+    if (rowIndex_ && !rowIndex_->complete)
+    {
+        rowIndex_->scans.resize(params_.interleaveMode == interleave_mode::none ? static_cast<size_t>(params_.components) : 1);
+    }
+
+    if (parallelDecoding_ && params_.interleaveMode == interleave_mode::none && params_.components > 1 &&
+        TryDecodeComponentsInParallel(rawPixels, static_cast<size_t>(bytesPerPlane)))
+        return;
+
+    // Note: componentIndex_ is a member as decoding of a partial source continues at the component it stopped.
+    while (componentIndex_ < params_.components)
     {
         if (state_ == state::scan_section)
         {
-            ReadStartOfScan(componentIndex == 0);
+            // A start of scan segment that is not yet completely available is read again when more data is available.
+            const ByteStreamInfo startOfScan{byteStream_};
+            try
+            {
+                ReadStartOfScan(componentIndex_ == 0);
+            }
+            catch (const jpegls_error&)
+            {
+                byteStream_ = startOfScan;
+                throw;
+            }
+        }
+
+        ByteStreamInfo componentPixels{rawPixels};
+        SkipBytes(componentPixels, static_cast<size_t>(bytesPerPlane) * componentIndex_);
+
+        if (!TryDecodeRestartIntervalsInParallel(componentPixels))
+        {
+            DecoderStrategy& codec = GetCodec(0, params_);
+            try
+            {
+                if (scanSuspended_)
+                {
+                    const TraceSpan span{tracer_, trace_event::scan, 0, static_cast<uint32_t>(componentIndex_)};
+                    codec.ResumeScan(byteStream_);
+                }
+                else
+                {
+                    codec.SetRestartInterval(std::min(restartInterval_, static_cast<uint32_t>(params_.height)));
+                    DecodeScan(codec, componentPixels, byteStream_, static_cast<size_t>(componentIndex_));
+                }
+
+                SkipRemainingScanData(static_cast<size_t>(componentIndex_));
+            }
+            catch (const jpegls_error& error)
+            {
+                scanSuspended_ = error.code() == jpegls_errc::need_more_data;
+                throw;
+            }
+            scanSuspended_ = false;
         }
 
-        unique_ptr<DecoderStrategy> codec = JlsCodecFactory<DecoderStrategy>().CreateCodec(params_, preset_coding_parameters_);
-        unique_ptr<ProcessLine> processLine(codec->CreateProcess(rawPixels));
-        codec->DecodeScan(move(processLine), rect_, byteStream_);
-        SkipBytes(rawPixels, static_cast<size_t>(bytesPerPlane));
         state_ = state::scan_section;
 
         if (params_.interleaveMode != interleave_mode::none)
-            return;
+            break;
 
-        componentIndex++;
+        componentIndex_++;
+    }
+
+    componentIndex_ = 0;
+    if (rowIndex_)
+    {
+        rowIndex_->complete = true;
     }
 }
 
 
+// Decodes a scan. While a row index is built its checkpoints are recorded, with a complete row index the decoding
+// starts at the last checkpoint before the region of interest.
+void JpegStreamReader::DecodeScan(DecoderStrategy& codec, const ByteStreamInfo rawPixels, ByteStreamInfo& scanData, const size_t scanIndex)
+{
+    const TraceSpan span{tracer_, trace_event::scan, 0, static_cast<uint32_t>(scanIndex)};
+    unique_ptr<ProcessLine> processLine(codec.CreateProcess(rawPixels));
+    if (!rowIndex_)
+    {
+        codec.DecodeScan(move(processLine), rect_, scanData);
+        return;
+    }
+
+    ScanIndex& scan = rowIndex_->scans[scanIndex];
+    if (!rowIndex_->complete)
+    {
+        scan.checkpoints.clear();
+        codec.RecordCheckpoints(&scan.checkpoints, rowIndex_->rowInterval);
+        try
+        {
+            codec.DecodeScan(move(processLine), rect_, scanData);
+        }
+        catch (...)
+        {
+            codec.RecordCheckpoints(nullptr, 0);
+            throw;
+        }
+        codec.RecordCheckpoints(nullptr, 0);
+        scan.endOffset = static_cast<size_t>(scanData.rawData - sourceStart_);
+        return;
+    }
+
+    const auto checkpoint = std::upper_bound(scan.checkpoints.cbegin(), scan.checkpoints.cend(), rect_.Y,
+                                             [](const int32_t line, const ScanCheckpoint& c) { return line < c.line; });
+    if (checkpoint == scan.checkpoints.cbegin())
+    {
+        codec.DecodeScan(move(processLine), rect_, scanData);
+    }
+    else
+    {
+        codec.DecodeScan(move(processLine), rect_, scanData, *(checkpoint - 1));
+    }
+}
+
+
+// In interleave mode none every component is stored in its own scan. These scans are independent, which makes it
+// possible to locate all scans up front and decode them in parallel.
+// Returns false when the preconditions are not met, the caller should then decode the scans sequentially.
+bool JpegStreamReader::TryDecodeComponentsInParallel(ByteStreamInfo rawPixels, const size_t bytesPerPlane)
+{
+    if (partialSource_ || !rawPixels.rawData || !byteStream_.rawData)
+        return false;
+
+    const ByteStreamInfo firstScanStream{byteStream_};
+    const JlsParameters firstScanParams{params_};
+    vector<std::pair<JlsParameters, ByteStreamInfo>> scans{{params_, byteStream_}};
+    uint8_t* const end = byteStream_.rawData + byteStream_.count;
+    while (scans.size() < static_cast<size_t>(params_.components))
+    {
+        uint8_t* markerCode = byteStream_.rawData;
+        do
+        {
+            markerCode = FindNextMarkerCode(markerCode, end);
+        } while (markerCode != end && IsRestartMarkerCode(*markerCode));
+
+        const bool startOfScanFound = markerCode != end && *markerCode == static_cast<uint8_t>(JpegMarkerCode::StartOfScan);
+        if (startOfScanFound)
+        {
+            SkipBytes(byteStream_, static_cast<size_t>(markerCode - byteStream_.rawData - 1));
+            ReadStartOfScan(false);
+        }
+
+        if (!startOfScanFound || params_.interleaveMode != interleave_mode::none)
+        {
+            // Let the sequential decoder handle (or report) the unexpected stream layout.
+            byteStream_ = firstScanStream;
+            params_ = firstScanParams;
+            return false;
+        }
+
+        scans.emplace_back(params_, byteStream_);
+    }
+
+    codecs_.resize(std::max(codecs_.size(), scans.size()));
+    ParallelFor(scans.size(), [&](const size_t component) {
+        ByteStreamInfo pixels{rawPixels};
+        SkipBytes(pixels, component * bytesPerPlane);
+
+        DecoderStrategy& codec = GetCodec(component, scans[component].first);
+        codec.SetRestartInterval(std::min(restartInterval_, static_cast<uint32_t>(params_.height)));
+        DecodeScan(codec, pixels, scans[component].second, component);
+    });
+
+    byteStream_ = scans.back().second;
+    SkipRemainingScanData(scans.size() - 1);
+    state_ = state::scan_section;
+    return true;
+}
+
+
+// Decoding of a scan stops after the last line of the region of interest. Move to the marker that follows the
+// scan data, to leave the stream at the same position as when the complete scan would have been decoded.
+void JpegStreamReader::SkipRemainingScanData(const size_t scanIndex)
+{
+    if (rect_.Y + rect_.Height >= params_.height || !byteStream_.rawData)
+        return;
+
+    if (rowIndex_ && rowIndex_->complete)
+    {
+        SkipBytes(byteStream_, static_cast<size_t>(sourceStart_ + rowIndex_->scans[scanIndex].endOffset - byteStream_.rawData));
+        return;
+    }
+
+    uint8_t* const end = byteStream_.rawData + byteStream_.count;
+    uint8_t* markerCode = byteStream_.rawData;
+    do
+    {
+        markerCode = FindNextMarkerCode(markerCode, end);
+    } while (markerCode != end && IsRestartMarkerCode(*markerCode));
+
+    if (markerCode == end)
+        throw jpegls_error{partialSource_ ? jpegls_errc::need_more_data : jpegls_errc::source_buffer_too_small};
+
+    SkipBytes(byteStream_, static_cast<size_t>(markerCode - byteStream_.rawData - 1));
+}
+
+
+// Restart intervals are coded independently (ISO/IEC 14495-1, C.2.5), which makes it possible to decode them in parallel.
+// Returns false when the preconditions are not met, the caller should then decode the scan sequentially.
+bool JpegStreamReader::TryDecodeRestartIntervalsInParallel(ByteStreamInfo rawPixels)
+{
+    if (!parallelDecoding_ || partialSource_ || (rowIndex_ && !rowIndex_->complete) || restartInterval_ == 0 || restartInterval_ >= static_cast<uint32_t>(params_.height) || !rawPixels.rawData || !byteStream_.rawData ||
+        rect_.X != 0 || rect_.Y != 0 || rect_.Width != params_.width || rect_.Height != params_.height)
+        return false;
+
+    const auto restartInterval = static_cast<int32_t>(restartInterval_);
+    const size_t intervalCount = (static_cast<size_t>(params_.height) + restartInterval - 1) / restartInterval;
+
+    // Locate the start of each restart interval.
+    vector<uint8_t*> intervalStarts{byteStream_.rawData};
+    uint8_t* position = byteStream_.rawData;
+    uint8_t* const end = byteStream_.rawData + byteStream_.count;
+    while (intervalStarts.size() < intervalCount)
+    {
+        position = FindNextMarkerCode(position, end);
+        if (position == end || *position != JpegRestartMarkerBase + (intervalStarts.size() - 1) % JpegRestartMarkerRange)
+            return false; // Let the sequential decoder report the problem.
+
+        ++position;
+        intervalStarts.push_back(position);
+    }
+
+    // Every worker decodes a contiguous range of restart intervals with its own codec, DecodeScan resets the codec
+    // state at the start of each interval. The last interval can have fewer lines: it has a codec of its own to not
+    // replace the cached codec of a worker on every decode.
+    const size_t workerCount = GetParallelForThreadCount(intervalCount);
+    codecs_.resize(std::max(codecs_.size(), workerCount + 1));
+    ByteStreamInfo lastIntervalStream{};
+    ParallelFor(workerCount, [&](const size_t worker) {
+        for (size_t index = worker * intervalCount / workerCount; index < (worker + 1) * intervalCount / workerCount; ++index)
+        {
+            const int32_t firstLine = static_cast<int32_t>(index) * restartInterval;
+
+            JlsParameters params{params_};
+            params.height = std::min(restartInterval, params_.height - firstLine);
+
+            const size_t offset = static_cast<size_t>(firstLine) * params_.stride;
+            const ByteStreamInfo pixels = FromByteArray(rawPixels.rawData + offset, rawPixels.count - offset);
+            ByteStreamInfo compressedData = FromByteArray(intervalStarts[index], static_cast<size_t>(end - intervalStarts[index]));
+
+            DecoderStrategy& codec = GetCodec(params.height == restartInterval ? worker : workerCount, params);
+            codec.SetRestartInterval(0);
+            const TraceSpan span{tracer_, trace_event::scan, static_cast<uint32_t>(index), static_cast<uint32_t>(componentIndex_)};
+            unique_ptr<ProcessLine> processLine(codec.CreateProcess(pixels));
+            codec.DecodeScan(move(processLine), JlsRect{0, 0, params.width, params.height}, compressedData);
+
+            if (index == intervalCount - 1)
+            {
+                lastIntervalStream = compressedData;
+            }
+        }
+    });
+
+    byteStream_ = lastIntervalStream;
+    return true;
+}
+
+
 void JpegStreamReader::ReadNBytes(std::vector<char>& destination, int byteCount)
 {
     for (int i = 0; i < byteCount; ++i)
@@ -98,6 +430,7 @@ void JpegStreamReader::ReadNBytes(std::vector<char>& destination, int byteCount)
 void JpegStreamReader::ReadHeader(spiff_header* header, bool* spiff_header_found)
 {
     ASSERT(state_ != state::scan_section);
+    const TraceSpan span{tracer_, trace_event::read_header};
 
     if (state_ == state::before_start_of_image)
     {
@@ -174,6 +507,7 @@ void JpegStreamReader::ValidateMarkerCode(JpegMarkerCode markerCode)
     {
     case JpegMarkerCode::StartOfFrameJpegLS:
     case JpegMarkerCode::JpegLSPresetParameters:
+    case JpegMarkerCode::DefineRestartInterval:
     case JpegMarkerCode::StartOfScan:
     case JpegMarkerCode::Comment:
     case JpegMarkerCode::ApplicationData0:
@@ -232,6 +566,9 @@ int JpegStreamReader::ReadMarkerSegment(JpegMarkerCode markerCode, int32_t segme
     case JpegMarkerCode::JpegLSPresetParameters:
         return ReadPresetParametersSegment(segmentSize);
 
+    case JpegMarkerCode::DefineRestartInterval:
+        return ReadDefineRestartIntervalSegment(segmentSize);
+
     case JpegMarkerCode::ApplicationData0:
     case JpegMarkerCode::ApplicationData1:
     case JpegMarkerCode::ApplicationData2:
@@ -252,7 +589,7 @@ int JpegStreamReader::ReadMarkerSegment(JpegMarkerCode markerCode, int32_t segme
     case JpegMarkerCode::ApplicationData8:
         return TryReadApplicationData8Segment(segmentSize, header, spiff_header_found);
 
-    // Other tags not supported (among which DNL DRI)
+    // Other tags not supported (among which DNL)
     default:
         ASSERT(false);
         return 0;
@@ -369,6 +706,33 @@ int JpegStreamReader::ReadPresetParametersSegment(int32_t segmentSize)
 }
 
 
+int JpegStreamReader::ReadDefineRestartIntervalSegment(int32_t segmentSize)
+{
+    // Note: The JPEG-LS standard supports a 2, 3 or 4 byte restart interval (see ISO/IEC 14495-1, C.2.5)
+    //       The original JPEG standard only supports 2 bytes (16 bit big endian).
+    switch (segmentSize)
+    {
+    case 2:
+        restartInterval_ = static_cast<uint32_t>(ReadUInt16());
+        break;
+
+    case 3:
+        restartInterval_ = static_cast<uint32_t>(ReadUInt16()) << 8U;
+        restartInterval_ += ReadByte();
+        break;
+
+    case 4:
+        restartInterval_ = ReadUInt32();
+        break;
+
+    default:
+        throw jpegls_error{jpegls_errc::invalid_marker_segment_size};
+    }
+
+    return segmentSize;
+}
+
+
 void JpegStreamReader::ReadStartOfScan(bool firstComponent)
 {
     if (!firstComponent)
@@ -420,7 +784,7 @@ uint8_t JpegStreamReader::ReadByte()
         return static_cast<uint8_t>(byteStream_.rawStream->sbumpc());
 
     if (byteStream_.count == 0)
-        throw jpegls_error{jpegls_errc::source_buffer_too_small};
+        throw jpegls_error{partialSource_ ? jpegls_errc::need_more_data : jpegls_errc::source_buffer_too_small};
 
     const uint8_t value = byteStream_.rawData[0];
     SkipBytes(byteStream_, 1);
@@ -6,18 +6,54 @@
 #include <charls/charls_legacy.h>
 #include <charls/public_types.h>
 
+#include "jls_codec_factory.h"
+#include "row_index.h"
+#include "trace.h"
+
 #include <cstdint>
 #include <vector>
 
 namespace charls {
 
 enum class JpegMarkerCode : uint8_t;
+class DecoderStrategy;
 
 // Purpose: minimal implementation to read a JPEG byte stream.
 class JpegStreamReader final
 {
 public:
     explicit JpegStreamReader(ByteStreamInfo byteStreamInfo) noexcept;
+    ~JpegStreamReader();
+
+    JpegStreamReader(const JpegStreamReader&) = delete;
+    JpegStreamReader(JpegStreamReader&&) = delete;
+    JpegStreamReader& operator=(const JpegStreamReader&) = delete;
+    JpegStreamReader& operator=(JpegStreamReader&&) = delete;
+
+    // Prepares the reader to read a new byte stream, the cached codecs are kept to allow their reuse.
+    void Reset(ByteStreamInfo byteStreamInfo) noexcept;
+
+    // A partial source contains the first part of the byte stream, when the data runs out need_more_data is thrown.
+    void SetPartialSource(bool value) noexcept
+    {
+        partialSource_ = value;
+    }
+
+    // Replaces the partial source with a source that contains more data, the source may have been moved.
+    void ExtendSource(ByteStreamInfo byteStreamInfo) noexcept;
+
+    // An incomplete row index is built by the next Read call, a complete row index is used to start the decoding
+    // of a region of interest at the nearest checkpoint. The index must match the source.
+    void SetRowIndex(RowIndex* rowIndex) noexcept
+    {
+        rowIndex_ = rowIndex;
+    }
+
+    // The tracer receives the stages of the decoding process, it is passed to the codecs used by the reader.
+    void SetTracer(const Tracer& tracer) noexcept
+    {
+        tracer_ = tracer;
+    }
 
     JlsParameters& GetMetadata() noexcept
     {
@@ -29,6 +65,17 @@ class JpegStreamReader final
         return preset_coding_parameters_;
     }
 
+#ifdef CHARLS_ENABLE_STATISTICS
+    // Adds the statistics of all cached codecs, these are kept when the reader is reset.
+    void AddStatistics(coding_statistics& total) const noexcept;
+    void ResetStatistics() noexcept;
+#endif
+
+    uint32_t GetRestartInterval() const noexcept
+    {
+        return restartInterval_;
+    }
+
     void Read(ByteStreamInfo rawPixels);
     void ReadHeader(spiff_header* header = nullptr, bool* spiff_header_found = nullptr);
 
@@ -47,6 +94,12 @@ class JpegStreamReader final
         rect_ = rect;
     }
 
+    // The component scans of interleave mode none and the restart intervals of a scan are decoded in parallel when possible.
+    void SetParallelDecoding(const bool value) noexcept
+    {
+        parallelDecoding_ = value;
+    }
+
     void ReadStartOfScan(bool firstComponent);
     uint8_t ReadByte();
 
@@ -64,11 +117,17 @@ class JpegStreamReader final
     int ReadStartOfFrameSegment(int32_t segmentSize);
     static int ReadComment() noexcept;
     int ReadPresetParametersSegment(int32_t segmentSize);
+    int ReadDefineRestartIntervalSegment(int32_t segmentSize);
     int TryReadApplicationData8Segment(int32_t segmentSize, spiff_header* header, bool* spiff_header_found);
     int TryReadSpiffHeaderSegment(spiff_header* header, bool& spiff_header_found);
 
     int TryReadHPColorTransformSegment();
     void AddComponent(uint8_t componentId);
+    bool TryDecodeComponentsInParallel(ByteStreamInfo rawPixels, size_t bytesPerPlane);
+    bool TryDecodeRestartIntervalsInParallel(ByteStreamInfo rawPixels);
+    void DecodeScan(DecoderStrategy& codec, ByteStreamInfo rawPixels, ByteStreamInfo& scanData, size_t scanIndex);
+    void SkipRemainingScanData(size_t scanIndex);
+    DecoderStrategy& GetCodec(size_t index, const JlsParameters& params);
 
     enum class state
     {
@@ -82,11 +141,20 @@ class JpegStreamReader final
     };
 
     ByteStreamInfo byteStream_;
+    const uint8_t* sourceStart_{};
+    bool partialSource_{};
+    bool scanSuspended_{};
+    int32_t componentIndex_{};
     JlsParameters params_{};
     jpegls_pc_parameters preset_coding_parameters_{};
     JlsRect rect_{};
+    uint32_t restartInterval_{};
+    bool parallelDecoding_{};
     std::vector<uint8_t> componentIds_;
     state state_{};
+    std::vector<CodecCache<DecoderStrategy>> codecs_;
+    RowIndex* rowIndex_{};
+    Tracer tracer_{};
 };
 
 } // namespace charls
@@ -11,6 +11,7 @@
 
 #include <array>
 #include <cassert>
+#include <cstring>
 #include <vector>
 
 using std::array;
@@ -36,6 +37,24 @@ void JpegStreamWriter::WriteEndOfImage()
 }
 
 
+void JpegStreamWriter::WriteScanData(const void* data, const size_t dataSize)
+{
+    if (destination_.rawStream)
+    {
+        if (static_cast<size_t>(destination_.rawStream->sputn(static_cast<const char*>(data), static_cast<std::streamsize>(dataSize))) != dataSize)
+            throw jpegls_error{jpegls_errc::destination_buffer_too_small};
+
+        return;
+    }
+
+    if (dataSize > GetLength())
+        throw jpegls_error{jpegls_errc::destination_buffer_too_small};
+
+    std::memcpy(GetPos(), data, dataSize);
+    byteOffset_ += dataSize;
+}
+
+
 void JpegStreamWriter::WriteSpiffHeaderSegment(const spiff_header& header)
 {
     ASSERT(header.height > 0);
@@ -133,6 +152,18 @@ void JpegStreamWriter::WriteJpegLSPresetParametersSegment(const jpegls_pc_parame
 }
 
 
+void JpegStreamWriter::WriteDefineRestartIntervalSegment(const uint32_t restartInterval)
+{
+    ASSERT(restartInterval <= UINT16_MAX);
+
+    // Create a DRI segment with a 2 byte restart interval (Lr = 4), ISO/IEC 14495-1, C.2.5
+    vector<uint8_t> segment;
+    push_back(segment, static_cast<uint16_t>(restartInterval)); // Ri = Restart interval
+
+    WriteSegment(JpegMarkerCode::DefineRestartInterval, segment.data(), segment.size());
+}
+
+
 void JpegStreamWriter::WriteStartOfScanSegment(int componentCount, int allowedLossyError, interleave_mode interleaveMode)
 {
     ASSERT(componentCount > 0 && componentCount <= UINT8_MAX);
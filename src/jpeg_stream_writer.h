@@ -59,6 +59,13 @@ class JpegStreamWriter final
     /// <param name="componentCount">The component count.</param>
     void WriteStartOfFrameSegment(int width, int height, int bitsPerSample, int componentCount);
 
+    /// <summary>
+    /// Writes a JPEG Define Restart Interval (DRI) segment.
+    /// This segment is documented in ISO/IEC 14495-1, C.2.5 and T.81, B.2.4.4.
+    /// </summary>
+    /// <param name="restartInterval">The number of lines (MCUs) between 2 restart markers.</param>
+    void WriteDefineRestartIntervalSegment(uint32_t restartInterval);
+
     /// <summary>
     /// Writes a JPEG-LS Start Of Scan (SOS) segment.
     /// </summary>
@@ -69,6 +76,13 @@ class JpegStreamWriter final
 
     void WriteEndOfImage();
 
+    /// <summary>
+    /// Writes a block of already encoded scan data (the bit stream that follows a SOS segment).
+    /// </summary>
+    /// <param name="data">The encoded scan data.</param>
+    /// <param name="dataSize">The size of the encoded scan data in bytes.</param>
+    void WriteScanData(const void* data, std::size_t dataSize);
+
     std::size_t GetBytesWritten() const noexcept
     {
         return byteOffset_;
@@ -67,19 +67,44 @@ unique_ptr<Strategy> create_codec(const Traits& traits, const JlsParameters& par
 namespace charls {
 
 // Lookup tables to replace code with lookup tables.
-// To avoid threading issues, all tables are created when the program is loaded.
+// The tables are function local statics: C++11 guarantees a thread safe initialization on first use.
 
-// Lookup table: decode symbols that are smaller or equal to 8 bit (16 tables for each value of k)
-CTable decodingTables[16] = {InitTable(0), InitTable(1), InitTable(2), InitTable(3),
-                             InitTable(4), InitTable(5), InitTable(6), InitTable(7),
-                             InitTable(8), InitTable(9), InitTable(10), InitTable(11),
-                             InitTable(12), InitTable(13), InitTable(14), InitTable(15)};
+// Lookup table: decode symbols that are smaller or equal to CHARLS_DECODING_TABLE_BITS bits (16 tables for each value of k)
+const std::array<CTable, 16>& GetDecodingTables()
+{
+    static const std::array<CTable, 16> decodingTables{{InitTable(0), InitTable(1), InitTable(2), InitTable(3),
+                                                        InitTable(4), InitTable(5), InitTable(6), InitTable(7),
+                                                        InitTable(8), InitTable(9), InitTable(10), InitTable(11),
+                                                        InitTable(12), InitTable(13), InitTable(14), InitTable(15)}};
+    return decodingTables;
+}
 
-// Lookup tables: sample differences to bin indexes.
-vector<signed char> rgquant8Ll = CreateQLutLossless(8);
-vector<signed char> rgquant10Ll = CreateQLutLossless(10);
-vector<signed char> rgquant12Ll = CreateQLutLossless(12);
-vector<signed char> rgquant16Ll = CreateQLutLossless(16);
+// Lookup tables: sample differences to bin indexes, only the table of the used bit count is created.
+const vector<signed char>& GetQuantizationLutLossless(const int32_t bitCount)
+{
+    switch (bitCount)
+    {
+    case 8:
+    {
+        static const vector<signed char> rgquant8Ll{CreateQLutLossless(8)};
+        return rgquant8Ll;
+    }
+    case 10:
+    {
+        static const vector<signed char> rgquant10Ll{CreateQLutLossless(10)};
+        return rgquant10Ll;
+    }
+    case 12:
+    {
+        static const vector<signed char> rgquant12Ll{CreateQLutLossless(12)};
+        return rgquant12Ll;
+    }
+    default:
+        ASSERT(bitCount == 16);
+        static const vector<signed char> rgquant16Ll{CreateQLutLossless(16)};
+        return rgquant16Ll;
+    }
+}
 
 
 template<typename Strategy>
@@ -125,17 +150,44 @@ unique_ptr<Strategy> JlsCodecFactory<Strategy>::CreateOptimizedCodec(const JlsPa
     {
         if (params.interleaveMode == interleave_mode::sample)
         {
-            if (params.components == 3 && params.bitsPerSample == 8)
-                return create_codec<Strategy>(LosslessTraits<Triplet<uint8_t>, 8>(), params);
-            if (params.components == 4 && params.bitsPerSample == 8)
-                return create_codec<Strategy>(LosslessTraits<Quad<uint8_t>, 8>(), params);
+            if (params.components == 3)
+            {
+                switch (params.bitsPerSample)
+                {
+                case 8:
+                    return create_codec<Strategy>(LosslessTraits<Triplet<uint8_t>, 8>(), params);
+                case 10:
+                    return create_codec<Strategy>(LosslessTraits<Triplet<uint16_t>, 10>(), params);
+                case 12:
+                    return create_codec<Strategy>(LosslessTraits<Triplet<uint16_t>, 12>(), params);
+                case 16:
+                    return create_codec<Strategy>(LosslessTraits<Triplet<uint16_t>, 16>(), params);
+                default:
+                    break;
+                }
+            }
+            else
+            {
+                switch (params.bitsPerSample)
+                {
+                case 8:
+                    return create_codec<Strategy>(LosslessTraits<Quad<uint8_t>, 8>(), params);
+                case 16:
+                    return create_codec<Strategy>(LosslessTraits<Quad<uint16_t>, 16>(), params);
+                default:
+                    break;
+                }
+            }
         }
         else
         {
+            // Note: line interleaved images code one component at a time and use the monochrome traits.
             switch (params.bitsPerSample)
             {
             case 8:
                 return create_codec<Strategy>(LosslessTraits<uint8_t, 8>(), params);
+            case 10:
+                return create_codec<Strategy>(LosslessTraits<uint16_t, 10>(), params);
             case 12:
                 return create_codec<Strategy>(LosslessTraits<uint16_t, 12>(), params);
             case 16:
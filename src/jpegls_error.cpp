@@ -99,6 +99,18 @@ const char* CHARLS_API_CALLING_CONVENTION charls_get_error_message(jpegls_errc e
     case jpegls_errc::missing_end_of_spiff_directory:
         return "Invalid JPEG-LS stream, SPIFF header without End Of Directory (EOD) entry";
 
+    case jpegls_errc::restart_marker_not_found:
+        return "Invalid JPEG-LS stream, the expected restart (RSTm) marker was not found at the end of a restart interval";
+
+    case jpegls_errc::callback_failed:
+        return "The callback function returned a failure, the operation has been aborted";
+
+    case jpegls_errc::need_more_data:
+        return "The partial source buffer doesn't contain enough data to continue, extend it with the next received data";
+
+    case jpegls_errc::statistics_not_enabled:
+        return "The coding statistics are not available, CharLS has been built without the CMake option CHARLS_ENABLE_STATISTICS";
+
     case jpegls_errc::invalid_parameter_bits_per_sample:
         return "Invalid JPEG-LS stream, The bit per sample (sample precision) parameter is not in the range [2, 16]";
 
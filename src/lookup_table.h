@@ -8,6 +8,13 @@
 #include <array>
 #include <cassert>
 
+// The number of bits that is resolved with one lookup in the Golomb decoding tables [8, 12].
+// Wider tables resolve more of the longer codes of 12 and 16 bit images without a bit by bit decode,
+// at the cost of more memory (16 tables * 2^bits * 4 bytes).
+#ifndef CHARLS_DECODING_TABLE_BITS
+#define CHARLS_DECODING_TABLE_BITS 12
+#endif
+
 namespace charls {
 
 // Tables for fast decoding of short Golomb Codes.
@@ -16,8 +23,8 @@ struct Code final
     Code() = default;
 
     Code(int32_t value, int32_t length) noexcept :
-        value_{value},
-        length_{length}
+        value_{static_cast<int16_t>(value)},
+        length_{static_cast<int16_t>(length)}
     {
     }
 
@@ -31,25 +38,27 @@ struct Code final
         return length_;
     }
 
-    int32_t value_{};
-    int32_t length_{};
+    // Note: 16 bit members keep the tables small, codes that fit in a table have small values.
+    int16_t value_{};
+    int16_t length_{};
 };
 
 
 class CTable final
 {
 public:
-    static constexpr size_t byte_bit_count = 8;
+    static constexpr size_t code_bit_count = CHARLS_DECODING_TABLE_BITS;
+    static_assert(code_bit_count >= 8 && code_bit_count <= 12, "CHARLS_DECODING_TABLE_BITS must be in the range [8, 12]");
 
-    void AddEntry(const uint8_t value, const Code c) noexcept
+    void AddEntry(const uint32_t value, const Code c) noexcept
     {
         const int32_t length = c.GetLength();
-        ASSERT(static_cast<size_t>(length) <= byte_bit_count);
+        ASSERT(static_cast<size_t>(length) <= code_bit_count);
 
-        for (size_t i = 0; i < static_cast<size_t>(1U) << (byte_bit_count - length); ++i)
+        for (size_t i = 0; i < static_cast<size_t>(1U) << (code_bit_count - length); ++i)
         {
-            ASSERT(types_[(static_cast<size_t>(value) << (byte_bit_count - length)) + i].GetLength() == 0);
-            types_[(static_cast<size_t>(value) << (byte_bit_count - length)) + i] = c;
+            ASSERT(types_[(static_cast<size_t>(value) << (code_bit_count - length)) + i].GetLength() == 0);
+            types_[(static_cast<size_t>(value) << (code_bit_count - length)) + i] = c;
         }
     }
 
@@ -59,7 +68,7 @@ class CTable final
     }
 
 private:
-    std::array<Code, 1 << byte_bit_count> types_;
+    std::array<Code, 1 << code_bit_count> types_;
 };
 
 } // namespace charls
@@ -8,7 +8,7 @@
 
 namespace charls {
 
-// Optimized trait classes for lossless compression of 8 bit color and 8/16 bit monochrome images.
+// Optimized trait classes for lossless compression of 8, 10, 12 and 16 bit monochrome and color images.
 // This class assumes MaximumSampleValue correspond to a whole number of bits, and no custom ResetValue is set when encoding.
 // The point of this is to have the most optimized code for the most common and most demanding scenario.
 template<typename sample, int32_t bitsPerPixel>
@@ -128,9 +128,10 @@ struct LosslessTraits<Triplet<T>, bpp> final : LosslessTraitsImpl<T, bpp>
         return lhs == rhs;
     }
 
+    // Note: the mask is needed when bpp is less than the bit count of T (optimized away by the compiler otherwise).
     FORCE_INLINE static T ComputeReconstructedSample(int32_t Px, int32_t errorValue) noexcept
     {
-        return static_cast<T>(Px + errorValue);
+        return static_cast<T>(LosslessTraitsImpl<T, bpp>::MAXVAL & (Px + errorValue));
     }
 };
 
@@ -150,9 +151,10 @@ struct LosslessTraits<Quad<T>, bpp> final : LosslessTraitsImpl<T, bpp>
         return lhs == rhs;
     }
 
+    // Note: the mask is needed when bpp is less than the bit count of T (optimized away by the compiler otherwise).
     FORCE_INLINE static T ComputeReconstructedSample(int32_t Px, int32_t errorValue) noexcept
     {
-        return static_cast<T>(Px + errorValue);
+        return static_cast<T>(LosslessTraitsImpl<T, bpp>::MAXVAL & (Px + errorValue));
     }
 };
 
@@ -0,0 +1,102 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::exception_ptr;
+using std::size_t;
+using std::thread;
+using std::vector;
+
+namespace charls {
+
+namespace {
+
+thread_local bool isPoolWorkerThread{};
+
+} // namespace
+
+
+void MarkAsPoolWorkerThread() noexcept
+{
+    isPoolWorkerThread = true;
+}
+
+
+size_t GetParallelForThreadCount(const size_t count) noexcept
+{
+    return isPoolWorkerThread ? 1 : std::min(count, static_cast<size_t>(std::max(thread::hardware_concurrency(), 1U)));
+}
+
+
+void ParallelFor(const size_t count, const std::function<void(size_t)>& action)
+{
+    const size_t threadCount = GetParallelForThreadCount(count);
+    if (threadCount <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            action(i);
+        }
+        return;
+    }
+
+    atomic<size_t> nextIndex{};
+    atomic<bool> failed{};
+    exception_ptr firstException;
+    std::mutex exceptionMutex;
+
+    const auto worker = [&]() noexcept {
+        for (size_t i = nextIndex++; i < count && !failed; i = nextIndex++)
+        {
+            try
+            {
+                action(i);
+            }
+            catch (...)
+            {
+                const std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!firstException)
+                {
+                    firstException = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    vector<thread> threads;
+    threads.reserve(threadCount - 1);
+    try
+    {
+        for (size_t i = 0; i < threadCount - 1; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+    }
+    catch (const std::system_error&)
+    {
+        // Not all threads could be started: continue with the ones that are running.
+    }
+
+    worker(); // The calling thread participates as a worker.
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    if (firstException)
+        std::rethrow_exception(firstException);
+}
+
+} // namespace charls
@@ -0,0 +1,23 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace charls {
+
+// Purpose: executes action(0) .. action(count - 1) on a set of worker threads and waits until all are done.
+// The first exception thrown by an action is rethrown on the calling thread, remaining work items are skipped.
+// When called from a worker thread of a pool the actions are executed on the calling thread.
+void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& action);
+
+// Returns the number of threads (including the calling thread) ParallelFor uses to execute count actions.
+std::size_t GetParallelForThreadCount(std::size_t count) noexcept;
+
+// Purpose: marks the calling thread as a worker thread of a pool. The pool already keeps all hardware threads busy,
+// more threads started by ParallelFor on every worker would only oversubscribe the CPU.
+void MarkAsPoolWorkerThread() noexcept;
+
+} // namespace charls
@@ -0,0 +1,158 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <charls/jpegls_error.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <streambuf>
+#include <vector>
+
+namespace charls {
+
+// Purpose: stream buffer that reduces the decoded rows to a preview while they are decoded. Every block of
+// scale x scale pixels is averaged (box filter) and the samples can be windowed to 8 bits. Only one decoded row
+// and the sums of one preview row are kept in memory, the full resolution image is never stored.
+class PreviewDestinationBuffer final : public std::basic_streambuf<char>
+{
+public:
+    PreviewDestinationBuffer(void* destination, const size_t destinationSize, const size_t stride,
+                             const uint32_t width, const uint32_t height, const int32_t samplesPerPixel,
+                             const size_t bytesPerSample, const preview_options& options) :
+        destination_{static_cast<uint8_t*>(destination)},
+        destinationEnd_{static_cast<uint8_t*>(destination) + destinationSize},
+        stride_{stride},
+        width_{width},
+        height_{height},
+        samplesPerPixel_{static_cast<size_t>(samplesPerPixel)},
+        bytesPerSample_{bytesPerSample},
+        scale_{options.scale_factor},
+        windowLow_{options.window_low},
+        windowHigh_{options.window_high},
+        row_(width * samplesPerPixel_ * bytesPerSample),
+        sums_(static_cast<size_t>(PreviewSize(width, scale_)) * samplesPerPixel_)
+    {
+        setp(row_.data(), row_.data() + row_.size());
+    }
+
+    static uint32_t PreviewSize(const uint32_t size, const uint32_t scale) noexcept
+    {
+        return (size + scale - 1) / scale;
+    }
+
+    // Processes the last decoded row, which is complete but not yet processed as no byte has been written after it.
+    void Flush()
+    {
+        if (pptr() == epptr())
+        {
+            ProcessRow();
+        }
+    }
+
+protected:
+    int_type overflow(const int_type value) override
+    {
+        Flush();
+
+        if (traits_type::eq_int_type(value, traits_type::eof()))
+            return traits_type::not_eof(value);
+
+        *pptr() = traits_type::to_char_type(value);
+        pbump(1);
+        return value;
+    }
+
+private:
+    void ProcessRow()
+    {
+        if (bytesPerSample_ == 1)
+        {
+            AddRow(reinterpret_cast<const uint8_t*>(row_.data()));
+        }
+        else
+        {
+            AddRow(reinterpret_cast<const uint16_t*>(row_.data()));
+        }
+        setp(row_.data(), row_.data() + row_.size());
+
+        // In interleave mode none the planes are stored after each other, a plane can end with an incomplete block.
+        ++blockRows_;
+        ++planeRow_;
+        if (blockRows_ == scale_ || planeRow_ == height_)
+        {
+            WriteRow();
+            blockRows_ = 0;
+            if (planeRow_ == height_)
+            {
+                planeRow_ = 0;
+            }
+        }
+    }
+
+    template<typename Sample>
+    void AddRow(const Sample* row) noexcept
+    {
+        for (uint32_t x = 0; x < width_; ++x)
+        {
+            uint32_t* sums = &sums_[static_cast<size_t>(x / scale_) * samplesPerPixel_];
+            for (size_t i = 0; i < samplesPerPixel_; ++i)
+            {
+                sums[i] += row[x * samplesPerPixel_ + i];
+            }
+        }
+    }
+
+    void WriteRow()
+    {
+        const bool window = windowHigh_ > windowLow_;
+        const size_t rowSize = sums_.size() * (window ? 1 : bytesPerSample_);
+        if (static_cast<size_t>(destinationEnd_ - destination_) < rowSize)
+            throw jpegls_error{jpegls_errc::destination_buffer_too_small};
+
+        for (size_t i = 0; i < sums_.size(); ++i)
+        {
+            const uint32_t columns = std::min(scale_, width_ - static_cast<uint32_t>(i / samplesPerPixel_) * scale_);
+            const uint32_t count = columns * blockRows_;
+            uint32_t value = (sums_[i] + count / 2) / count;
+
+            if (window)
+            {
+                value = value <= windowLow_ ? 0 : value >= windowHigh_ ? 255 :
+                    ((value - windowLow_) * 255 + (windowHigh_ - windowLow_) / 2) / (windowHigh_ - windowLow_);
+                destination_[i] = static_cast<uint8_t>(value);
+            }
+            else if (bytesPerSample_ == 1)
+            {
+                destination_[i] = static_cast<uint8_t>(value);
+            }
+            else
+            {
+                const auto sample = static_cast<uint16_t>(value);
+                memcpy(destination_ + i * 2, &sample, sizeof sample);
+            }
+        }
+
+        std::fill(sums_.begin(), sums_.end(), 0U);
+        destination_ += std::min(stride_, static_cast<size_t>(destinationEnd_ - destination_));
+    }
+
+    uint8_t* destination_;
+    uint8_t* destinationEnd_;
+    size_t stride_;
+    uint32_t width_;
+    uint32_t height_;
+    size_t samplesPerPixel_;
+    size_t bytesPerSample_;
+    uint32_t scale_;
+    uint32_t windowLow_;
+    uint32_t windowHigh_;
+    uint32_t blockRows_{};
+    uint32_t planeRow_{};
+    std::vector<char> row_;
+    std::vector<uint32_t> sums_;
+};
+
+} // namespace charls
@@ -94,10 +94,11 @@ inline void ByteSwap(void* data, int count)
 class PostProcessSingleStream final : public ProcessLine
 {
 public:
-    PostProcessSingleStream(std::basic_streambuf<char>* rawData, uint32_t stride, size_t bytesPerPixel) noexcept :
+    PostProcessSingleStream(std::basic_streambuf<char>* rawData, uint32_t stride, size_t bytesPerPixel, bool swapBytes) noexcept :
         rawData_{rawData},
         bytesPerPixel_{bytesPerPixel},
-        bytesPerLine_{stride}
+        bytesPerLine_{stride},
+        swapBytes_{swapBytes}
     {
     }
 
@@ -113,7 +114,7 @@ class PostProcessSingleStream final : public ProcessLine
             bytesToRead = bytesToRead - bytesRead;
         }
 
-        if (bytesPerPixel_ == 2)
+        if (swapBytes_ && bytesPerPixel_ == 2)
         {
             ByteSwap(static_cast<unsigned char*>(destination), 2 * pixelCount);
         }
@@ -136,19 +137,30 @@ class PostProcessSingleStream final : public ProcessLine
     std::basic_streambuf<char>* rawData_;
     size_t bytesPerPixel_;
     size_t bytesPerLine_;
+    bool swapBytes_;
 };
 
 
+// The transform functions below access the pixels as arrays of samples and not through the Triplet/Quad members.
+// This keeps the loops free of union member access and allows the compiler to vectorize them (SSE2/AVX2 on x86,
+// NEON on ARM), with the color transform fused into the (de)interleave of the samples.
+
 template<typename TRANSFORM, typename T>
 void TransformLineToQuad(const T* ptypeInput, int32_t pixelStrideIn, Quad<T>* byteBuffer, int32_t pixelStride, TRANSFORM& transform) noexcept
 {
+    static_assert(sizeof(Quad<T>) == 4 * sizeof(T), "Quad<T> must be 4 packed samples");
+
     const int cpixel = std::min(pixelStride, pixelStrideIn);
-    Quad<T>* ptypeBuffer = byteBuffer;
+    T* samples = reinterpret_cast<T*>(byteBuffer);
 
     for (auto x = 0; x < cpixel; ++x)
     {
-        const Quad<T> pixel(transform(ptypeInput[x], ptypeInput[x + pixelStrideIn], ptypeInput[x + 2 * pixelStrideIn]), ptypeInput[x + 3 * pixelStrideIn]);
-        ptypeBuffer[x] = pixel;
+        const Triplet<T> color = transform(ptypeInput[x], ptypeInput[x + pixelStrideIn], ptypeInput[x + 2 * pixelStrideIn]);
+
+        samples[4 * x] = color.v1;
+        samples[4 * x + 1] = color.v2;
+        samples[4 * x + 2] = color.v3;
+        samples[4 * x + 3] = ptypeInput[x + 3 * pixelStrideIn];
     }
 }
 
@@ -156,18 +168,19 @@ void TransformLineToQuad(const T* ptypeInput, int32_t pixelStrideIn, Quad<T>* by
 template<typename TRANSFORM, typename T>
 void TransformQuadToLine(const Quad<T>* byteInput, int32_t pixelStrideIn, T* ptypeBuffer, int32_t pixelStride, TRANSFORM& transform) noexcept
 {
+    static_assert(sizeof(Quad<T>) == 4 * sizeof(T), "Quad<T> must be 4 packed samples");
+
     const auto cpixel = std::min(pixelStride, pixelStrideIn);
-    const Quad<T>* ptypeBufferIn = byteInput;
+    const T* samples = reinterpret_cast<const T*>(byteInput);
 
     for (auto x = 0; x < cpixel; ++x)
     {
-        const Quad<T> color = ptypeBufferIn[x];
-        const Quad<T> colorTransformed(transform(color.v1, color.v2, color.v3), color.v4);
+        const Triplet<T> colorTransformed = transform(samples[4 * x], samples[4 * x + 1], samples[4 * x + 2]);
 
         ptypeBuffer[x] = colorTransformed.v1;
         ptypeBuffer[x + pixelStride] = colorTransformed.v2;
         ptypeBuffer[x + 2 * pixelStride] = colorTransformed.v3;
-        ptypeBuffer[x + 3 * pixelStride] = colorTransformed.v4;
+        ptypeBuffer[x + 3 * pixelStride] = samples[4 * x + 3];
     }
 }
 
@@ -186,9 +199,18 @@ void TransformRgbToBgr(T* pDest, int samplesPerPixel, int pixelCount) noexcept
 template<typename TRANSFORM, typename T>
 void TransformLine(Triplet<T>* pDest, const Triplet<T>* pSrc, int pixelCount, TRANSFORM& transform) noexcept
 {
+    static_assert(sizeof(Triplet<T>) == 3 * sizeof(T), "Triplet<T> must be 3 packed samples");
+
+    T* destination = reinterpret_cast<T*>(pDest);
+    const T* source = reinterpret_cast<const T*>(pSrc);
+
     for (auto i = 0; i < pixelCount; ++i)
     {
-        pDest[i] = transform(pSrc[i].v1, pSrc[i].v2, pSrc[i].v3);
+        const Triplet<T> color = transform(source[3 * i], source[3 * i + 1], source[3 * i + 2]);
+
+        destination[3 * i] = color.v1;
+        destination[3 * i + 1] = color.v2;
+        destination[3 * i + 2] = color.v3;
     }
 }
 
@@ -196,9 +218,19 @@ void TransformLine(Triplet<T>* pDest, const Triplet<T>* pSrc, int pixelCount, TR
 template<typename TRANSFORM, typename T>
 void TransformLine(Quad<T>* pDest, const Quad<T>* pSrc, int pixelCount, TRANSFORM& transform) noexcept
 {
+    static_assert(sizeof(Quad<T>) == 4 * sizeof(T), "Quad<T> must be 4 packed samples");
+
+    T* destination = reinterpret_cast<T*>(pDest);
+    const T* source = reinterpret_cast<const T*>(pSrc);
+
     for (auto i = 0; i < pixelCount; ++i)
     {
-        pDest[i] = Quad<T>(transform(pSrc[i].v1, pSrc[i].v2, pSrc[i].v3), pSrc[i].v4);
+        const Triplet<T> color = transform(source[4 * i], source[4 * i + 1], source[4 * i + 2]);
+
+        destination[4 * i] = color.v1;
+        destination[4 * i + 1] = color.v2;
+        destination[4 * i + 2] = color.v3;
+        destination[4 * i + 3] = source[4 * i + 3];
     }
 }
 
@@ -206,12 +238,18 @@ void TransformLine(Quad<T>* pDest, const Quad<T>* pSrc, int pixelCount, TRANSFOR
 template<typename TRANSFORM, typename T>
 void TransformLineToTriplet(const T* ptypeInput, int32_t pixelStrideIn, Triplet<T>* byteBuffer, int32_t pixelStride, TRANSFORM& transform) noexcept
 {
+    static_assert(sizeof(Triplet<T>) == 3 * sizeof(T), "Triplet<T> must be 3 packed samples");
+
     const auto cpixel = std::min(pixelStride, pixelStrideIn);
-    Triplet<T>* ptypeBuffer = byteBuffer;
+    T* samples = reinterpret_cast<T*>(byteBuffer);
 
     for (auto x = 0; x < cpixel; ++x)
     {
-        ptypeBuffer[x] = transform(ptypeInput[x], ptypeInput[x + pixelStrideIn], ptypeInput[x + 2 * pixelStrideIn]);
+        const Triplet<T> color = transform(ptypeInput[x], ptypeInput[x + pixelStrideIn], ptypeInput[x + 2 * pixelStrideIn]);
+
+        samples[3 * x] = color.v1;
+        samples[3 * x + 1] = color.v2;
+        samples[3 * x + 2] = color.v3;
     }
 }
 
@@ -219,13 +257,14 @@ void TransformLineToTriplet(const T* ptypeInput, int32_t pixelStrideIn, Triplet<
 template<typename TRANSFORM, typename T>
 void TransformTripletToLine(const Triplet<T>* byteInput, int32_t pixelStrideIn, T* ptypeBuffer, int32_t pixelStride, TRANSFORM& transform) noexcept
 {
+    static_assert(sizeof(Triplet<T>) == 3 * sizeof(T), "Triplet<T> must be 3 packed samples");
+
     const auto cpixel = std::min(pixelStride, pixelStrideIn);
-    const Triplet<T>* ptypeBufferIn = byteInput;
+    const T* samples = reinterpret_cast<const T*>(byteInput);
 
     for (auto x = 0; x < cpixel; ++x)
     {
-        const Triplet<T> color = ptypeBufferIn[x];
-        const Triplet<T> colorTransformed = transform(color.v1, color.v2, color.v3);
+        const Triplet<T> colorTransformed = transform(samples[3 * x], samples[3 * x + 1], samples[3 * x + 2]);
 
         ptypeBuffer[x] = colorTransformed.v1;
         ptypeBuffer[x + pixelStride] = colorTransformed.v2;
@@ -0,0 +1,57 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "context.h"
+#include "context_run_mode.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace charls {
+
+// The position in the scan (relative to the start of the scan data) and the bits in the cache of the bit reader.
+struct BitReaderState final
+{
+    std::size_t position;
+    std::size_t readCache;
+    int32_t validBits;
+};
+
+
+// The coding state at the start of a line of a scan: decoding can continue at this line when this state is restored.
+struct ScanCheckpoint final
+{
+    int32_t line;
+    int32_t restartMarkerIndex;
+    std::array<JlsContext, 365> contexts;
+    std::array<CContextRunMode, 2> contextRunmode;
+    std::vector<int32_t> runIndexes;
+    BitReaderState bitReader;
+
+    // The previous line(s) as stored in the line buffer, empty when the line buffer is still intact.
+    std::vector<uint8_t> previousLines;
+};
+
+
+// The checkpoints of a single scan, ordered by line.
+struct ScanIndex final
+{
+    std::vector<ScanCheckpoint> checkpoints;
+    std::size_t endOffset; // position after the scan data, relative to the start of the source.
+};
+
+
+// Purpose: an index with a checkpoint every rowInterval rows of every scan. The index is built by decoding the
+// complete image once, after that the decoding of a region of interest can start at the nearest checkpoint.
+struct RowIndex final
+{
+    uint32_t rowInterval;
+    bool complete;
+    std::vector<ScanIndex> scans;
+};
+
+} // namespace charls
@@ -3,24 +3,27 @@
 
 #pragma once
 
+#include "coding_statistics.h"
 #include "color_transform.h"
 #include "context.h"
 #include "context_run_mode.h"
+#include "cpu_dispatch.h"
+#include "jpeg_marker_code.h"
 #include "lookup_table.h"
 #include "process_line.h"
 
 #include <array>
+#include <limits>
 #include <sstream>
 
 // This file contains the code for handling a "scan". Usually an image is encoded as a single scan.
 
 namespace charls {
 
-extern CTable decodingTables[16];
-extern std::vector<signed char> rgquant8Ll;
-extern std::vector<signed char> rgquant10Ll;
-extern std::vector<signed char> rgquant12Ll;
-extern std::vector<signed char> rgquant16Ll;
+// The lookup tables are created (thread safe) when they are used for the first time: processes that only read
+// headers or only encode don't pay for the tables they don't use.
+const std::array<CTable, 16>& GetDecodingTables();
+const std::vector<signed char>& GetQuantizationLutLossless(int32_t bitCount);
 
 constexpr int32_t ApplySign(int32_t i, int32_t sign) noexcept
 {
@@ -94,6 +97,9 @@ constexpr int32_t ComputeContextID(int32_t Q1, int32_t Q2, int32_t Q3) noexcept
     return (Q1 * 9 + Q2) * 9 + Q3;
 }
 
+// Number of pixels for which the context gradients of the previous line are computed at once.
+constexpr int32_t PartialContextsBlockSize = 64;
+
 
 template<typename Traits, typename Strategy>
 class JlsCodec final : public Strategy
@@ -111,6 +117,8 @@ class JlsCodec final : public Strategy
         {
             Info().components = 1;
         }
+
+        InitDecodingTables(static_cast<Strategy*>(nullptr));
     }
 
     void SetPresets(const jpegls_pc_parameters& presets) override
@@ -150,6 +158,7 @@ class JlsCodec final : public Strategy
     }
 
     void InitQuantizationLUT();
+    void ComputePartialContexts(int32_t begin, int32_t end, int32_t previousLineLeft, int32_t previousLineRight) noexcept;
 
     int32_t DecodeValue(int32_t k, int32_t limit, int32_t qbpp);
     FORCE_INLINE void EncodeMappedValue(int32_t k, int32_t mappedError, int32_t limit);
@@ -170,13 +179,16 @@ class JlsCodec final : public Strategy
     SAMPLE DecodeRIPixel(int32_t Ra, int32_t Rb);
     int32_t DecodeRunPixels(PIXEL Ra, PIXEL* startPos, int32_t cpixelMac);
     int32_t DoRunMode(int32_t startIndex, DecoderStrategy*);
+    int32_t DoRunMode(int32_t startIndex, PIXEL Ra, DecoderStrategy*);
 
     void EncodeRIError(CContextRunMode& ctx, int32_t errorValue);
     SAMPLE EncodeRIPixel(int32_t x, int32_t Ra, int32_t Rb);
     Triplet<SAMPLE> EncodeRIPixel(Triplet<SAMPLE> x, Triplet<SAMPLE> Ra, Triplet<SAMPLE> Rb);
     Quad<SAMPLE> EncodeRIPixel(Quad<SAMPLE> x, Quad<SAMPLE> Ra, Quad<SAMPLE> Rb);
     void EncodeRunPixels(int32_t runLength, bool endOfLine);
+    int32_t FindRunLength(const PIXEL* startPos, PIXEL Ra, int32_t pixelCount) const noexcept;
     int32_t DoRunMode(int32_t index, EncoderStrategy*);
+    int32_t DoRunMode(int32_t index, PIXEL Ra, EncoderStrategy*);
 
     FORCE_INLINE SAMPLE DoRegular(int32_t Qs, int32_t, int32_t pred, DecoderStrategy*);
     FORCE_INLINE SAMPLE DoRegular(int32_t Qs, int32_t x, int32_t pred, EncoderStrategy*);
@@ -184,10 +196,70 @@ class JlsCodec final : public Strategy
     void DoLine(SAMPLE* dummy);
     void DoLine(Triplet<SAMPLE>* dummy);
     void DoLine(Quad<SAMPLE>* dummy);
+    void DoLineInPlace(int32_t previousLineLeft);
     void DoScan();
+    void InitLines();
+    void DoLines();
+    void SaveCheckpoint(DecoderStrategy*);
+    void RestoreCheckpoint(const ByteStreamInfo& compressedData, const ScanCheckpoint& checkpoint);
+    static void SaveCheckpoint(EncoderStrategy*) noexcept
+    {
+    }
+
+    // Decoding stops after the last line of the region of interest, the lines after it are not needed.
+    int32_t GetLineCount(DecoderStrategy*) noexcept
+    {
+        return std::min(Info().height, rect_.Y + rect_.Height);
+    }
+
+    int32_t GetLineCount(EncoderStrategy*) noexcept
+    {
+        return Info().height;
+    }
+    bool TryDoScanInPlace(SAMPLE* dummy);
+    static bool TryDoScanInPlace(Triplet<SAMPLE>* /*dummy*/) noexcept
+    {
+        return false;
+    }
+    static bool TryDoScanInPlace(Quad<SAMPLE>* /*dummy*/) noexcept
+    {
+        return false;
+    }
+    bool IsInPlaceCodingPossible(DecoderStrategy*) noexcept;
+    bool IsInPlaceCodingPossible(EncoderStrategy*) noexcept;
+
+    // The bytes of the 16 bit samples are only swapped when the pixels are read from a stream of the legacy API.
+    static constexpr bool SwapStreamBytes(DecoderStrategy*) noexcept
+    {
+        return false;
+    }
+    bool SwapStreamBytes(EncoderStrategy*) const noexcept
+    {
+        return !Strategy::nativeByteOrderStream_;
+    }
+
+    static void StoreInPlace(PIXEL* position, const PIXEL value, DecoderStrategy*) noexcept
+    {
+        *position = value;
+    }
+
+    static void StoreInPlace(const PIXEL* /*position*/, const PIXEL /*value*/, EncoderStrategy*) noexcept
+    {
+        // The encoder only reads the caller's pixels, lossless coding reconstructs the same values.
+    }
 
     void InitParams(int32_t t1, int32_t t2, int32_t t3, int32_t nReset);
 
+    void InitDecodingTables(DecoderStrategy*)
+    {
+        decodingTables_ = &GetDecodingTables();
+    }
+
+    static void InitDecodingTables(EncoderStrategy*) noexcept
+    {
+    }
+    void ResetParameters() noexcept;
+
 #if defined(__clang__)
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Winconsistent-missing-override"
@@ -196,6 +268,8 @@ class JlsCodec final : public Strategy
     // Note: depending on the base class EncodeScan OR DecodeScan will be virtual and abstract, cannot use override in all cases.
     size_t EncodeScan(std::unique_ptr<ProcessLine> processLine, ByteStreamInfo& compressedData);
     void DecodeScan(std::unique_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData);
+    void ResumeScan(ByteStreamInfo& compressedData);
+    void DecodeScan(std::unique_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData, const ScanCheckpoint& checkpoint);
 
 #if defined(__clang__)
 #pragma clang diagnostic pop
@@ -209,6 +283,7 @@ class JlsCodec final : public Strategy
     int32_t T1{};
     int32_t T2{};
     int32_t T3{};
+    int32_t resetValue_{};
 
     // compression context
     std::array<JlsContext, 365> contexts_;
@@ -216,9 +291,23 @@ class JlsCodec final : public Strategy
     int32_t RUNindex_{};
     PIXEL* previousLine_{};
     PIXEL* currentLine_{};
+    std::vector<PIXEL> lineBuffer_;
+    std::vector<int32_t> runIndexes_;
+    std::vector<int32_t> partialContexts_;
+    uint8_t* inPlacePixels_{};
+    int32_t line_{};
+    int32_t restartMarkerIndex_{};
+
+    // The coding state at the start of the current line, to resume decoding of a partial source.
+    ScanCheckpoint checkpoint_{};
+
+    const std::array<CTable, 16>* decodingTables_{};
+
+    // The CPU specific kernels, selected when the first codec is created.
+    const CodecKernels* kernels_{&GetCodecKernels()};
 
     // quantization lookup table
-    signed char* pquant_{};
+    const signed char* pquant_{};
     std::vector<signed char> rgquant_;
 };
 
@@ -232,16 +321,20 @@ typename Traits::SAMPLE JlsCodec<Traits, Strategy>::DoRegular(int32_t Qs, int32_
     const int32_t k = ctx.GetGolomb();
     const int32_t Px = traits.CorrectPrediction(pred + ApplySign(ctx.C, sign));
 
+    COUNT_EVENT(AddRegularSample(Strategy::statistics_, k));
+
     int32_t ErrVal;
-    const Code& code = decodingTables[k].Get(Strategy::PeekByte());
+    const Code& code = (*decodingTables_)[k].Get(Strategy::PeekBits(static_cast<int32_t>(CTable::code_bit_count)));
     if (code.GetLength() != 0)
     {
+        COUNT_EVENT(++Strategy::statistics_.golomb_table_hit_count);
         Strategy::Skip(code.GetLength());
         ErrVal = code.GetValue();
         ASSERT(std::abs(ErrVal) < 65535);
     }
     else
     {
+        COUNT_EVENT(++Strategy::statistics_.golomb_table_miss_count);
         ErrVal = UnMapErrVal(DecodeValue(k, traits.LIMIT, traits.qbpp));
         if (std::abs(ErrVal) > 65535)
             throw jpegls_error{jpegls_errc::invalid_encoded_data};
@@ -264,6 +357,7 @@ typename Traits::SAMPLE JlsCodec<Traits, Strategy>::DoRegular(int32_t Qs, int32_
     const int32_t k = ctx.GetGolomb();
     const int32_t Px = traits.CorrectPrediction(pred + ApplySign(ctx.C, sign));
     const int32_t ErrVal = traits.ComputeErrVal(ApplySign(x - Px, sign));
+    COUNT_EVENT(AddRegularSample(Strategy::statistics_, k));
 
     EncodeMappedValue(k, GetMappedErrVal(ctx.GetErrorCorrection(k | traits.NEAR) ^ ErrVal), traits.LIMIT);
     ctx.UpdateVariables(ErrVal, traits.NEAR, traits.RESET);
@@ -289,11 +383,11 @@ inline CTable InitTable(int32_t k) noexcept
         // Q is not used when k != 0
         const int32_t merrval = GetMappedErrVal(nerr);
         const std::pair<int32_t, int32_t> pairCode = CreateEncodedValue(k, merrval);
-        if (static_cast<size_t>(pairCode.first) > CTable::byte_bit_count)
+        if (static_cast<size_t>(pairCode.first) > CTable::code_bit_count)
             break;
 
         const Code code(nerr, static_cast<short>(pairCode.first));
-        table.AddEntry(static_cast<uint8_t>(pairCode.second), code);
+        table.AddEntry(static_cast<uint32_t>(pairCode.second), code);
     }
 
     for (short nerr = -1;; nerr--)
@@ -301,11 +395,11 @@ inline CTable InitTable(int32_t k) noexcept
         // Q is not used when k != 0
         const int32_t merrval = GetMappedErrVal(nerr);
         const std::pair<int32_t, int32_t> pairCode = CreateEncodedValue(k, merrval);
-        if (static_cast<size_t>(pairCode.first) > CTable::byte_bit_count)
+        if (static_cast<size_t>(pairCode.first) > CTable::code_bit_count)
             break;
 
         const Code code = Code(nerr, static_cast<short>(pairCode.first));
-        table.AddEntry(static_cast<uint8_t>(pairCode.second), code);
+        table.AddEntry(static_cast<uint32_t>(pairCode.second), code);
     }
 
     return table;
@@ -375,24 +469,10 @@ void JlsCodec<Traits, Strategy>::InitQuantizationLUT()
         const jpegls_pc_parameters presets{compute_default(traits.MAXVAL, traits.NEAR)};
         if (presets.threshold1 == T1 && presets.threshold2 == T2 && presets.threshold3 == T3)
         {
-            if (traits.bpp == 8)
-            {
-                pquant_ = &rgquant8Ll[rgquant8Ll.size() / 2];
-                return;
-            }
-            if (traits.bpp == 10)
+            if (traits.bpp == 8 || traits.bpp == 10 || traits.bpp == 12 || traits.bpp == 16)
             {
-                pquant_ = &rgquant10Ll[rgquant10Ll.size() / 2];
-                return;
-            }
-            if (traits.bpp == 12)
-            {
-                pquant_ = &rgquant12Ll[rgquant12Ll.size() / 2];
-                return;
-            }
-            if (traits.bpp == 16)
-            {
-                pquant_ = &rgquant16Ll[rgquant16Ll.size() / 2];
+                const std::vector<signed char>& lut = GetQuantizationLutLossless(traits.bpp);
+                pquant_ = &lut[lut.size() / 2];
                 return;
             }
         }
@@ -401,16 +481,57 @@ void JlsCodec<Traits, Strategy>::InitQuantizationLUT()
     const int32_t RANGE = 1 << traits.bpp;
 
     rgquant_.resize(static_cast<size_t>(RANGE) * 2);
-
-    pquant_ = &rgquant_[RANGE];
     for (int32_t i = -RANGE; i < RANGE; ++i)
     {
-        pquant_[i] = QuantizeGradientOrg(i);
+        rgquant_[static_cast<size_t>(RANGE) + i] = QuantizeGradientOrg(i);
     }
+    pquant_ = &rgquant_[RANGE];
 }
 
 MSVC_WARNING_UNSUPPRESS()
 
+
+// Computes (Q1 * 9 + Q2) * 9 of the context ID for the pixels [begin, end) of the current line: the gradients Q1 and Q2
+// only depend on the previous line. The quantization is done with comparisons instead of the lookup table,
+// this makes the loop branch free and allows the compiler to vectorize it (SSE2/AVX2 on x86, NEON on ARM).
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::ComputePartialContexts(const int32_t begin, const int32_t end, const int32_t previousLineLeft, const int32_t previousLineRight) noexcept
+{
+    const int32_t nearLossless = traits.NEAR;
+    const int32_t t1 = T1;
+    const int32_t t2 = T2;
+    const int32_t t3 = T3;
+    const auto quantize = [=](const int32_t Di) noexcept {
+        return static_cast<int32_t>(Di > nearLossless) + static_cast<int32_t>(Di >= t1) + static_cast<int32_t>(Di >= t2) + static_cast<int32_t>(Di >= t3) -
+               static_cast<int32_t>(Di < -nearLossless) - static_cast<int32_t>(Di <= -t1) - static_cast<int32_t>(Di <= -t2) - static_cast<int32_t>(Di <= -t3);
+    };
+
+    const PIXEL* previousLine = previousLine_;
+    int32_t* partialContexts = partialContexts_.data();
+    const int32_t lastIndex = width_ - 1;
+
+    int32_t index = begin;
+    if (index == 0)
+    {
+        partialContexts[0] = (quantize((lastIndex == 0 ? previousLineRight : previousLine[1]) - previousLine[0]) * 9 +
+                              quantize(previousLine[0] - previousLineLeft)) * 9;
+        index = 1;
+    }
+
+    const int32_t innerEnd = std::min(end, lastIndex);
+    for (; index < innerEnd; ++index)
+    {
+        partialContexts[index] = (quantize(previousLine[index + 1] - previousLine[index]) * 9 +
+                                  quantize(previousLine[index] - previousLine[index - 1])) * 9;
+    }
+
+    if (end == width_ && lastIndex > 0)
+    {
+        partialContexts[lastIndex] = (quantize(previousLineRight - previousLine[lastIndex]) * 9 +
+                                      quantize(previousLine[lastIndex] - previousLine[lastIndex - 1])) * 9;
+    }
+}
+
 template<typename Traits, typename Strategy>
 signed char JlsCodec<Traits, Strategy>::QuantizeGradientOrg(int32_t Di) const noexcept
 {
@@ -555,6 +676,8 @@ typename Traits::SAMPLE JlsCodec<Traits, Strategy>::EncodeRIPixel(int32_t x, int
 template<typename Traits, typename Strategy>
 void JlsCodec<Traits, Strategy>::EncodeRunPixels(int32_t runLength, bool endOfLine)
 {
+    COUNT_EVENT(AddRun(Strategy::statistics_, runLength, !endOfLine));
+
     while (runLength >= static_cast<int32_t>(1 << J[RUNindex_]))
     {
         Strategy::AppendOnesToBitStream(1);
@@ -579,18 +702,33 @@ void JlsCodec<Traits, Strategy>::EncodeRunPixels(int32_t runLength, bool endOfLi
 template<typename Traits, typename Strategy>
 int32_t JlsCodec<Traits, Strategy>::DecodeRunPixels(PIXEL Ra, PIXEL* startPos, int32_t cpixelMac)
 {
+    // Every 1 bit codes a complete block of 2^J[RUNindex] pixels (or the rest of the line), a 0 bit ends the sequence.
+    // All 1 bits available in the bit cache are decoded in a single step.
     int32_t index = 0;
-    while (Strategy::ReadBit())
+    for (;;)
     {
-        const int count = std::min(1 << J[RUNindex_], int(cpixelMac - index));
-        index += count;
-        ASSERT(index <= cpixelMac);
+        const int32_t onesCount = Strategy::PeekLeadingOnes();
+        if (onesCount == 0)
+        {
+            Strategy::Skip(1);
+            break;
+        }
 
-        if (count == (1 << J[RUNindex_]))
+        int32_t bitCount = 0;
+        while (bitCount < onesCount && index < cpixelMac)
         {
-            IncrementRunIndex();
+            const int32_t blockSize = 1 << J[RUNindex_];
+            const int32_t count = std::min(blockSize, cpixelMac - index);
+            index += count;
+            ++bitCount;
+
+            if (count == blockSize)
+            {
+                IncrementRunIndex();
+            }
         }
 
+        Strategy::Skip(bitCount);
         if (index == cpixelMac)
             break;
     }
@@ -604,14 +742,46 @@ int32_t JlsCodec<Traits, Strategy>::DecodeRunPixels(PIXEL Ra, PIXEL* startPos, i
     if (index > cpixelMac)
         throw jpegls_error{jpegls_errc::invalid_encoded_data};
 
-    for (int32_t i = 0; i < index; ++i)
+    std::fill_n(startPos, index, Ra);
+    return index;
+}
+
+
+// Returns the number of pixels that are equal to Ra (within NEAR). Lossless runs are found with the CPU specific
+// kernel, near-lossless pixels are compared in blocks without an early exit inside the block, which allows the
+// compiler to vectorize the comparisons.
+template<typename Traits, typename Strategy>
+int32_t JlsCodec<Traits, Strategy>::FindRunLength(const PIXEL* startPos, const PIXEL Ra, const int32_t pixelCount) const noexcept
+{
+    if (traits.NEAR == 0)
+        return CountEqualPixels(*kernels_, startPos, Ra, pixelCount);
+
+    constexpr int32_t blockSize = 16;
+
+    int32_t runLength = 0;
+    while (runLength + blockSize <= pixelCount)
     {
-        startPos[i] = Ra;
+        bool allNear = true;
+        for (int32_t i = 0; i < blockSize; ++i)
+        {
+            allNear &= traits.IsNear(startPos[runLength + i], Ra);
+        }
+
+        if (!allNear)
+            break;
+
+        runLength += blockSize;
     }
 
-    return index;
+    while (runLength < pixelCount && traits.IsNear(startPos[runLength], Ra))
+    {
+        ++runLength;
+    }
+
+    return runLength;
 }
 
+
 template<typename Traits, typename Strategy>
 int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t index, EncoderStrategy*)
 {
@@ -621,23 +791,37 @@ int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t index, EncoderStrategy*)
 
     const PIXEL Ra = ptypeCurX[-1];
 
-    int32_t runLength = 0;
+    const int32_t runLength = FindRunLength(ptypeCurX, Ra, ctypeRem);
+    std::fill_n(ptypeCurX, runLength, Ra);
 
-    while (traits.IsNear(ptypeCurX[runLength], Ra))
-    {
-        ptypeCurX[runLength] = Ra;
-        runLength++;
+    EncodeRunPixels(runLength, runLength == ctypeRem);
 
-        if (runLength == ctypeRem)
-            break;
-    }
+    if (runLength == ctypeRem)
+        return runLength;
+
+    ptypeCurX[runLength] = EncodeRIPixel(ptypeCurX[runLength], Ra, ptypePrevX[runLength]);
+    DecrementRunIndex();
+    return runLength + 1;
+}
+
+
+// Lossless variant that doesn't write to the current line, which can then be the caller's (read-only) source buffer.
+template<typename Traits, typename Strategy>
+int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t index, const PIXEL Ra, EncoderStrategy*)
+{
+    ASSERT(traits.NEAR == 0);
+    const int32_t ctypeRem = width_ - index;
+    const PIXEL* ptypeCurX = currentLine_ + index;
+    const PIXEL* ptypePrevX = previousLine_ + index;
+
+    const int32_t runLength = FindRunLength(ptypeCurX, Ra, ctypeRem);
 
     EncodeRunPixels(runLength, runLength == ctypeRem);
 
     if (runLength == ctypeRem)
         return runLength;
 
-    ptypeCurX[runLength] = EncodeRIPixel(ptypeCurX[runLength], Ra, ptypePrevX[runLength]);
+    EncodeRIPixel(ptypeCurX[runLength], Ra, ptypePrevX[runLength]);
     DecrementRunIndex();
     return runLength + 1;
 }
@@ -646,10 +830,16 @@ int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t index, EncoderStrategy*)
 template<typename Traits, typename Strategy>
 int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t startIndex, DecoderStrategy*)
 {
-    const PIXEL Ra = currentLine_[startIndex - 1];
+    return DoRunMode(startIndex, currentLine_[startIndex - 1], static_cast<DecoderStrategy*>(nullptr));
+}
 
+
+template<typename Traits, typename Strategy>
+int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t startIndex, const PIXEL Ra, DecoderStrategy*)
+{
     const int32_t runLength = DecodeRunPixels(Ra, currentLine_ + startIndex, width_ - startIndex);
     const int32_t endIndex = startIndex + runLength;
+    COUNT_EVENT(AddRun(Strategy::statistics_, runLength, endIndex != width_));
 
     if (endIndex == width_)
         return endIndex - startIndex;
@@ -666,18 +856,25 @@ int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t startIndex, DecoderStrateg
 template<typename Traits, typename Strategy>
 void JlsCodec<Traits, Strategy>::DoLine(SAMPLE*)
 {
-    int32_t index = 0;
-    int32_t Rb = previousLine_[index - 1];
-    int32_t Rd = previousLine_[index];
+    const int32_t* partialContexts = partialContexts_.data();
 
+    int32_t index = 0;
+    int32_t partialContextsEnd = 0;
     while (index < width_)
     {
+        // The partial contexts are computed in blocks: the pixels of a run don't need them.
+        if (index >= partialContextsEnd)
+        {
+            partialContextsEnd = std::min(index + PartialContextsBlockSize, width_);
+            ComputePartialContexts(index, partialContextsEnd, previousLine_[-1], previousLine_[width_]);
+        }
+
         const int32_t Ra = currentLine_[index - 1];
-        const int32_t Rc = Rb;
-        Rb = Rd;
-        Rd = previousLine_[index + 1];
+        const int32_t Rb = previousLine_[index];
+        const int32_t Rc = previousLine_[index - 1];
 
-        const int32_t Qs = ComputeContextID(QuantizeGradient(Rd - Rb), QuantizeGradient(Rb - Rc), QuantizeGradient(Rc - Ra));
+        const int32_t Qs = partialContexts[index] + QuantizeGradient(Rc - Ra);
+        ASSERT(Qs == ComputeContextID(QuantizeGradient(previousLine_[index + 1] - Rb), QuantizeGradient(Rb - Rc), QuantizeGradient(Rc - Ra)));
 
         if (Qs != 0)
         {
@@ -687,8 +884,48 @@ void JlsCodec<Traits, Strategy>::DoLine(SAMPLE*)
         else
         {
             index += DoRunMode(index, static_cast<Strategy*>(nullptr));
+        }
+    }
+}
+
+
+/// <summary>Encodes/Decodes a scan line of samples without accessing the edge pixels before and after the line</summary>
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DoLineInPlace(const int32_t previousLineLeft)
+{
+    const int32_t lastIndex = width_ - 1;
+    const int32_t* partialContexts = partialContexts_.data();
+
+    int32_t index = 0;
+    int32_t partialContextsEnd = 0;
+    int32_t Ra = previousLine_[0];
+    int32_t Rb = previousLineLeft;
+
+    while (index < width_)
+    {
+        if (index >= partialContextsEnd)
+        {
+            partialContextsEnd = std::min(index + PartialContextsBlockSize, width_);
+            ComputePartialContexts(index, partialContextsEnd, previousLineLeft, previousLine_[lastIndex]);
+        }
+
+        const int32_t Rc = Rb;
+        Rb = previousLine_[index];
+
+        const int32_t Qs = partialContexts[index] + QuantizeGradient(Rc - Ra);
+        ASSERT(Qs == ComputeContextID(QuantizeGradient(previousLine_[std::min(index + 1, lastIndex)] - Rb), QuantizeGradient(Rb - Rc), QuantizeGradient(Rc - Ra)));
+
+        if (Qs != 0)
+        {
+            Ra = DoRegular(Qs, currentLine_[index], GetPredictedValue(Ra, Rb, Rc), static_cast<Strategy*>(nullptr));
+            StoreInPlace(currentLine_ + index, static_cast<PIXEL>(Ra), static_cast<Strategy*>(nullptr));
+            index++;
+        }
+        else
+        {
+            index += DoRunMode(index, static_cast<PIXEL>(Ra), static_cast<Strategy*>(nullptr));
+            Ra = currentLine_[index - 1];
             Rb = previousLine_[index - 1];
-            Rd = previousLine_[index];
         }
     }
 }
@@ -769,45 +1006,209 @@ void JlsCodec<Traits, Strategy>::DoLine(Quad<SAMPLE>*)
 
 template<typename Traits, typename Strategy>
 void JlsCodec<Traits, Strategy>::DoScan()
+{
+    if (TryDoScanInPlace(static_cast<PIXEL*>(nullptr))) // dummy argument for overload resolution
+        return;
+
+    InitLines();
+    ResetParameters();
+    line_ = 0;
+    restartMarkerIndex_ = 0;
+
+    DoLines();
+}
+
+
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::InitLines()
 {
     const int32_t pixelStride = width_ + 4;
     const int components = Info().interleaveMode == interleave_mode::line ? Info().components : 1;
 
-    std::vector<PIXEL> vectmp(static_cast<size_t>(2) * components * pixelStride);
-    std::vector<int32_t> rgRUNindex(components);
+    // The line buffers are members to allow reuse of the allocated memory when the codec is used for multiple scans.
+    lineBuffer_.assign(static_cast<size_t>(2) * components * pixelStride, PIXEL{});
+    runIndexes_.assign(components, 0);
+    partialContexts_.resize(width_);
+}
+
 
-    for (int32_t line = 0; line < Info().height; ++line)
+// Codes the lines from line_ to the end of the scan.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DoLines()
+{
+    const int32_t pixelStride = width_ + 4;
+    const int components = Info().interleaveMode == interleave_mode::line ? Info().components : 1;
+    const int32_t lineCount = GetLineCount(static_cast<Strategy*>(nullptr));
+
+    for (; line_ < lineCount; ++line_)
     {
-        previousLine_ = &vectmp[1];
-        currentLine_ = &vectmp[1 + static_cast<size_t>(components) * pixelStride];
-        if ((line & 1) == 1)
+        SaveCheckpoint(static_cast<Strategy*>(nullptr));
+
+        // At the start of each restart interval the coding process is reset as if a new scan starts (ISO/IEC 14495-1, C.2.5).
+        if (Strategy::restartInterval_ != 0 && line_ != 0 && line_ % static_cast<int32_t>(Strategy::restartInterval_) == 0)
+        {
+            Strategy::OnRestartMarker(restartMarkerIndex_);
+            restartMarkerIndex_ = (restartMarkerIndex_ + 1) % JpegRestartMarkerRange;
+
+            ResetParameters();
+            std::fill(lineBuffer_.begin(), lineBuffer_.end(), PIXEL{});
+            std::fill(runIndexes_.begin(), runIndexes_.end(), 0);
+        }
+
+        previousLine_ = &lineBuffer_[1];
+        currentLine_ = &lineBuffer_[1 + static_cast<size_t>(components) * pixelStride];
+        if ((line_ & 1) == 1)
         {
             std::swap(previousLine_, currentLine_);
         }
 
-        Strategy::OnLineBegin(width_, currentLine_, pixelStride);
+        Strategy::OnLineBegin(width_, currentLine_, pixelStride, line_);
+        COUNT_EVENT(Strategy::BeginLineStatistics());
 
         for (int component = 0; component < components; ++component)
         {
-            RUNindex_ = rgRUNindex[component];
+            RUNindex_ = runIndexes_[component];
 
             // initialize edge pixels used for prediction
             previousLine_[width_] = previousLine_[width_ - 1];
             currentLine_[-1] = previousLine_[0];
             DoLine(static_cast<PIXEL*>(nullptr)); // dummy argument for overload resolution
 
-            rgRUNindex[component] = RUNindex_;
+            runIndexes_[component] = RUNindex_;
             previousLine_ += pixelStride;
             currentLine_ += pixelStride;
         }
 
-        if (rect_.Y <= line && line < rect_.Y + rect_.Height)
+        COUNT_EVENT(Strategy::EndLineStatistics());
+
+        if (rect_.Y <= line_ && line_ < rect_.Y + rect_.Height)
         {
-            Strategy::OnLineEnd(rect_.Width, currentLine_ + rect_.X - (static_cast<size_t>(components) * pixelStride), pixelStride);
+            Strategy::OnLineEnd(rect_.Width, currentLine_ + rect_.X - (static_cast<size_t>(components) * pixelStride), pixelStride, line_);
         }
     }
 
+    SaveCheckpoint(static_cast<Strategy*>(nullptr));
+
+    // When decoding stopped early the end of the scan is not reached, the caller needs to skip the remaining scan data.
+    if (lineCount == Info().height)
+    {
+        Strategy::EndScan();
+    }
+}
+
+
+// Saves the state that is modified while a line is decoded. Decoding only writes to the current line and
+// leaves the previous line intact: restoring this state allows decoding the line again when more data is available.
+// A checkpoint of a row index is recorded every checkpointInterval_ lines, it also saves the previous line as decoding
+// from this checkpoint starts with an empty line buffer.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::SaveCheckpoint(DecoderStrategy*)
+{
+    if (Strategy::partialSource_)
+    {
+        checkpoint_.line = line_;
+        checkpoint_.restartMarkerIndex = restartMarkerIndex_;
+        checkpoint_.contexts = contexts_;
+        checkpoint_.contextRunmode = contextRunmode_;
+        checkpoint_.runIndexes = runIndexes_;
+        checkpoint_.bitReader = Strategy::GetBitReaderState();
+    }
+
+    if (Strategy::recordedCheckpoints_ && line_ != 0 && line_ < Info().height && line_ % static_cast<int32_t>(Strategy::checkpointInterval_) == 0)
+    {
+        // The previous line is the half of the line buffer that DoLines selects as previous line for line_.
+        const size_t lineSize = lineBuffer_.size() / 2;
+        const auto previousLines = reinterpret_cast<const uint8_t*>(&lineBuffer_[(line_ & 1) == 1 ? lineSize : 0]);
+
+        Strategy::recordedCheckpoints_->push_back({line_, restartMarkerIndex_, contexts_, contextRunmode_, runIndexes_,
+                                                   Strategy::GetBitReaderState(),
+                                                   {previousLines, previousLines + lineSize * sizeof(PIXEL)}});
+    }
+}
+
+
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::RestoreCheckpoint(const ByteStreamInfo& compressedData, const ScanCheckpoint& checkpoint)
+{
+    Strategy::RestoreBitReaderState(compressedData, checkpoint.bitReader);
+    line_ = checkpoint.line;
+    restartMarkerIndex_ = checkpoint.restartMarkerIndex;
+    contexts_ = checkpoint.contexts;
+    contextRunmode_ = checkpoint.contextRunmode;
+    runIndexes_ = checkpoint.runIndexes;
+
+    if (!checkpoint.previousLines.empty())
+    {
+        const size_t lineSize = lineBuffer_.size() / 2;
+        ASSERT(checkpoint.previousLines.size() == lineSize * sizeof(PIXEL));
+        memcpy(&lineBuffer_[(line_ & 1) == 1 ? lineSize : 0], checkpoint.previousLines.data(), checkpoint.previousLines.size());
+    }
+}
+
+
+// Single component scans that need no conversion can be coded in place: the lines of the caller's buffer are used
+// as current and previous line, this avoids copying every line to or from the internal line buffer.
+template<typename Traits, typename Strategy>
+bool JlsCodec<Traits, Strategy>::TryDoScanInPlace(SAMPLE*)
+{
+    if (!IsInPlaceCodingPossible(static_cast<Strategy*>(nullptr)))
+        return false;
+
+    const size_t pixelStride = static_cast<size_t>(Info().stride) / sizeof(PIXEL);
+    PIXEL* const firstLine = reinterpret_cast<PIXEL*>(inPlacePixels_);
+
+    // The line before the first line of every restart interval is all zeros.
+    lineBuffer_.assign(width_, PIXEL{});
+    partialContexts_.resize(width_);
+    RUNindex_ = 0;
+    ResetParameters();
+    int32_t restartMarkerIndex = 0;
+    int32_t firstIntervalLine = 0;
+
+    for (int32_t line = 0; line < Info().height; ++line)
+    {
+        if (Strategy::restartInterval_ != 0 && line != 0 && line % static_cast<int32_t>(Strategy::restartInterval_) == 0)
+        {
+            Strategy::OnRestartMarker(restartMarkerIndex);
+            restartMarkerIndex = (restartMarkerIndex + 1) % JpegRestartMarkerRange;
+
+            ResetParameters();
+            RUNindex_ = 0;
+            firstIntervalLine = line;
+        }
+
+        currentLine_ = firstLine + line * pixelStride;
+        previousLine_ = line == firstIntervalLine ? lineBuffer_.data() : currentLine_ - pixelStride;
+
+        // The edge pixel left of the previous line is the first pixel of the line before it (or 0).
+        const int32_t previousLineLeft = line - 2 >= firstIntervalLine ? *(currentLine_ - 2 * pixelStride) : 0;
+        COUNT_EVENT(Strategy::BeginLineStatistics());
+        DoLineInPlace(previousLineLeft);
+        COUNT_EVENT(Strategy::EndLineStatistics());
+    }
+
     Strategy::EndScan();
+    return true;
+}
+
+
+template<typename Traits, typename Strategy>
+bool JlsCodec<Traits, Strategy>::IsInPlaceCodingPossible(DecoderStrategy*) noexcept
+{
+    return inPlacePixels_ && !Strategy::partialSource_ && reinterpret_cast<uintptr_t>(inPlacePixels_) % alignof(PIXEL) == 0 &&
+           Info().stride % sizeof(PIXEL) == 0 && Info().stride >= static_cast<int32_t>(width_ * sizeof(PIXEL)) &&
+           rect_.X == 0 && rect_.Y == 0 && rect_.Width == width_ && rect_.Height == Info().height;
+}
+
+
+// Only lossless coding of samples that use the full SAMPLE range reconstructs exactly the source values,
+// near-lossless coding needs to write the reconstructed values into the current line.
+template<typename Traits, typename Strategy>
+bool JlsCodec<Traits, Strategy>::IsInPlaceCodingPossible(EncoderStrategy*) noexcept
+{
+    return inPlacePixels_ && reinterpret_cast<uintptr_t>(inPlacePixels_) % alignof(PIXEL) == 0 &&
+           Info().stride % sizeof(PIXEL) == 0 && Info().stride >= static_cast<int32_t>(width_ * sizeof(PIXEL)) &&
+           traits.NEAR == 0 && traits.MAXVAL == std::numeric_limits<SAMPLE>::max();
 }
 
 
@@ -815,11 +1216,14 @@ void JlsCodec<Traits, Strategy>::DoScan()
 template<typename Traits, typename Strategy>
 std::unique_ptr<ProcessLine> JlsCodec<Traits, Strategy>::CreateProcess(ByteStreamInfo info)
 {
+    inPlacePixels_ = IsInterleaved() ? nullptr : info.rawData;
+
     if (!IsInterleaved())
     {
         return info.rawData ?
             std::unique_ptr<ProcessLine>(std::make_unique<PostProcessSingleComponent>(info.rawData, Info().stride, sizeof(typename Traits::PIXEL))) :
-            std::unique_ptr<ProcessLine>(std::make_unique<PostProcessSingleStream>(info.rawStream, Info().stride, sizeof(typename Traits::PIXEL)));
+            std::unique_ptr<ProcessLine>(std::make_unique<PostProcessSingleStream>(info.rawStream, Info().stride, sizeof(typename Traits::PIXEL),
+                                                                                   SwapStreamBytes(static_cast<Strategy*>(nullptr))));
     }
 
     if (Info().colorTransformation == color_transformation::none)
@@ -887,6 +1291,37 @@ void JlsCodec<Traits, Strategy>::DecodeScan(std::unique_ptr<ProcessLine> process
     DoScan();
     SkipBytes(compressedData, Strategy::GetCurBytePos() - compressedBytes);
 }
+
+
+// Continues decoding a scan of a partial source at the line that could not be decoded by the previous call.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::ResumeScan(ByteStreamInfo& compressedData)
+{
+    const uint8_t* compressedBytes = compressedData.rawData;
+
+    RestoreCheckpoint(compressedData, checkpoint_);
+
+    DoLines();
+    SkipBytes(compressedData, Strategy::GetCurBytePos() - compressedBytes);
+}
+
+
+// Decodes a scan from a checkpoint of a row index, the lines before the checkpoint are not decoded.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DecodeScan(std::unique_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData, const ScanCheckpoint& checkpoint)
+{
+    Strategy::processLine_ = std::move(processLine);
+
+    const uint8_t* compressedBytes = compressedData.rawData;
+    rect_ = rect;
+
+    Strategy::Init(compressedData);
+    InitLines();
+    RestoreCheckpoint(compressedData, checkpoint);
+
+    DoLines();
+    SkipBytes(compressedData, Strategy::GetCurBytePos() - compressedBytes);
+}
 MSVC_WARNING_UNSUPPRESS()
 
 // Initialize the codec data structures. Depends on JPEG-LS parameters like Threshold1-Threshold3.
@@ -896,17 +1331,24 @@ void JlsCodec<Traits, Strategy>::InitParams(int32_t t1, int32_t t2, int32_t t3,
     T1 = t1;
     T2 = t2;
     T3 = t3;
+    resetValue_ = nReset;
 
     InitQuantizationLUT();
+}
 
+
+// Resets the context variables to their initial state (ISO/IEC 14495-1, A.2.1). Required at the start of a scan and a restart interval.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::ResetParameters() noexcept
+{
     const JlsContext contextInitValue(std::max(2, (traits.RANGE + 32) / 64));
     for (auto& context : contexts_)
     {
         context = contextInitValue;
     }
 
-    contextRunmode_[0] = CContextRunMode(std::max(2, (traits.RANGE + 32) / 64), 0, nReset);
-    contextRunmode_[1] = CContextRunMode(std::max(2, (traits.RANGE + 32) / 64), 1, nReset);
+    contextRunmode_[0] = CContextRunMode(std::max(2, (traits.RANGE + 32) / 64), 0, resetValue_);
+    contextRunmode_[1] = CContextRunMode(std::max(2, (traits.RANGE + 32) / 64), 1, resetValue_);
     RUNindex_ = 0;
 }
 
@@ -0,0 +1,124 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <charls/jpegls_error.h>
+
+#include <algorithm>
+#include <streambuf>
+
+namespace charls {
+
+// Purpose: stream buffer that requests the rows of pixels that need to be encoded from a callback, a strip at a time.
+// Only the strip is kept in memory, which allows encoding of images that are not (yet) completely available.
+class StripSourceBuffer final : public std::basic_streambuf<char>
+{
+public:
+    StripSourceBuffer(void* strip, const size_t stripSize, const size_t rowSize, const uint32_t rowCount,
+                      const encode_rows_callback callback, void* userContext) :
+        strip_{static_cast<char*>(strip)},
+        rowSize_{rowSize},
+        rowsPerStrip_{static_cast<uint32_t>(std::min(stripSize / rowSize, static_cast<size_t>(rowCount)))},
+        remainingRows_{rowCount},
+        callback_{callback},
+        userContext_{userContext}
+    {
+        if (rowsPerStrip_ == 0)
+            throw jpegls_error{jpegls_errc::source_buffer_too_small};
+    }
+
+protected:
+    int_type underflow() override
+    {
+        if (remainingRows_ == 0)
+            return traits_type::eof();
+
+        const uint32_t rowCount = std::min(rowsPerStrip_, remainingRows_);
+        if (callback_(strip_, rowCount, userContext_) != 0)
+            throw jpegls_error{jpegls_errc::callback_failed};
+
+        const size_t size = rowCount * rowSize_;
+        remainingRows_ -= rowCount;
+        setg(strip_, strip_, strip_ + size);
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    char* strip_;
+    size_t rowSize_;
+    uint32_t rowsPerStrip_;
+    uint32_t remainingRows_;
+    encode_rows_callback callback_;
+    void* userContext_;
+};
+
+
+// Purpose: stream buffer that collects the decoded rows of pixels in a strip and passes every completed strip to a callback.
+class StripDestinationBuffer final : public std::basic_streambuf<char>
+{
+public:
+    StripDestinationBuffer(void* strip, const size_t stripSize, const size_t rowSize,
+                           const decode_rows_callback callback, void* userContext) :
+        strip_{static_cast<char*>(strip)},
+        rowSize_{rowSize},
+        callback_{callback},
+        userContext_{userContext}
+    {
+        const size_t rowsPerStrip = stripSize / rowSize;
+        if (rowsPerStrip == 0)
+            throw jpegls_error{jpegls_errc::destination_buffer_too_small};
+
+        setp(strip_, strip_ + rowsPerStrip * rowSize);
+    }
+
+    // Passes the rows that are completed to the callback, called when the strip is full and at the end of the image.
+    void FlushRows()
+    {
+        const auto rowCount = static_cast<uint32_t>(static_cast<size_t>(pptr() - pbase()) / rowSize_);
+        if (rowCount == 0)
+            return;
+
+        if (callback_(strip_, rowCount, userContext_) != 0)
+            throw jpegls_error{jpegls_errc::callback_failed};
+
+        setp(strip_, epptr());
+    }
+
+protected:
+    int_type overflow(const int_type value) override
+    {
+        FlushRows();
+
+        if (traits_type::eq_int_type(value, traits_type::eof()))
+            return traits_type::not_eof(value);
+
+        *pptr() = traits_type::to_char_type(value);
+        pbump(1);
+        return value;
+    }
+
+private:
+    char* strip_;
+    size_t rowSize_;
+    decode_rows_callback callback_;
+    void* userContext_;
+};
+
+
+// Purpose: stream buffer that discards the decoded pixels, used when only the decoding state is needed.
+class DiscardStreamBuffer final : public std::basic_streambuf<char>
+{
+protected:
+    std::streamsize xsputn(const char_type* /*s*/, const std::streamsize count) override
+    {
+        return count;
+    }
+
+    int_type overflow(const int_type value) override
+    {
+        return traits_type::not_eof(value);
+    }
+};
+
+} // namespace charls
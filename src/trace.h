@@ -0,0 +1,63 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <charls/public_types.h>
+
+#include <chrono>
+
+namespace charls {
+
+// The trace callback of an encoder or decoder, tracing is disabled when the callback is null.
+struct Tracer final
+{
+    trace_callback callback;
+    void* userContext;
+};
+
+
+// Purpose: reports the time between its construction and destruction as a span to the trace callback.
+// When tracing is disabled the clock is not read, the only cost is a test of the callback.
+class TraceSpan final
+{
+public:
+    TraceSpan(const Tracer& tracer, const trace_event event, const uint32_t index = 0, const uint32_t scan = 0) noexcept :
+        tracer_{tracer},
+        event_{event},
+        index_{index},
+        scan_{scan},
+        startTime_{tracer.callback ? Now() : 0}
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (tracer_.callback)
+        {
+            const trace_span span{event_, index_, scan_, startTime_, Now()};
+            tracer_.callback(&span, tracer_.userContext);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan(TraceSpan&&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+    TraceSpan& operator=(TraceSpan&&) = delete;
+
+private:
+    static uint64_t Now() noexcept
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    const Tracer tracer_;
+    const trace_event event_;
+    const uint32_t index_;
+    const uint32_t scan_;
+    const uint64_t startTime_;
+};
+
+} // namespace charls
@@ -8,8 +8,13 @@
 
 #include <cassert>
 #include <cstring>
+#include <type_traits>
 #include <vector>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 // Use an uppercase alias for assert to make it clear that it is a pre-processor macro.
 #define ASSERT(t) assert(t)
 
@@ -183,13 +188,15 @@ struct Triplet
 };
 
 
-inline bool operator==(const Triplet<uint8_t>& lhs, const Triplet<uint8_t>& rhs) noexcept
+template<typename T>
+bool operator==(const Triplet<T>& lhs, const Triplet<T>& rhs) noexcept
 {
     return lhs.v1 == rhs.v1 && lhs.v2 == rhs.v2 && lhs.v3 == rhs.v3;
 }
 
 
-inline bool operator!=(const Triplet<uint8_t>& lhs, const Triplet<uint8_t>& rhs) noexcept
+template<typename T>
+bool operator!=(const Triplet<T>& lhs, const Triplet<T>& rhs) noexcept
 {
     return !(lhs == rhs);
 }
@@ -222,6 +229,20 @@ struct Quad final : Triplet<sample>
 };
 
 
+template<typename T>
+bool operator==(const Quad<T>& lhs, const Quad<T>& rhs) noexcept
+{
+    return lhs.v1 == rhs.v1 && lhs.v2 == rhs.v2 && lhs.v3 == rhs.v3 && lhs.v4 == rhs.v4;
+}
+
+
+template<typename T>
+bool operator!=(const Quad<T>& lhs, const Quad<T>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+
 template<int size>
 struct FromBigEndian final
 {
@@ -252,6 +273,63 @@ struct FromBigEndian<8> final
 };
 
 
+// Portable implementation of CountLeadingZeros, value may not be 0.
+template<typename T>
+int32_t CountLeadingZerosPortable(T value) noexcept
+{
+    ASSERT(value != 0);
+    constexpr T highBit = static_cast<T>(1) << (sizeof(T) * 8 - 1);
+
+    int32_t count = 0;
+    while ((value & highBit) == 0)
+    {
+        value <<= 1;
+        ++count;
+    }
+
+    return count;
+}
+
+
+// Returns the number of 0 bits before the most significant 1 bit, value may not be 0.
+// Uses the count leading zeros (or bit scan reverse) instruction of the CPU when the compiler provides it.
+template<typename T>
+FORCE_INLINE int32_t CountLeadingZeros(const T value) noexcept
+{
+    static_assert(std::is_unsigned<T>::value && (sizeof(T) == 4 || sizeof(T) == 8), "T must be a 32 or 64 bit unsigned type");
+    ASSERT(value != 0);
+
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(T) == 8 ? __builtin_clzll(static_cast<unsigned long long>(value)) : __builtin_clz(static_cast<unsigned int>(value));
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (sizeof(T) == 8)
+    {
+#if defined(_M_X64) || defined(_M_ARM64)
+        _BitScanReverse64(&index, static_cast<unsigned __int64>(value));
+        return 63 - static_cast<int32_t>(index);
+#else
+        // 32-bit targets have no 64-bit bit scan: scan the upper and lower half separately.
+        const auto upper = static_cast<unsigned long>(static_cast<uint64_t>(value) >> 32);
+        if (upper != 0)
+        {
+            _BitScanReverse(&index, upper);
+            return 31 - static_cast<int32_t>(index);
+        }
+
+        _BitScanReverse(&index, static_cast<unsigned long>(value));
+        return 63 - static_cast<int32_t>(index);
+#endif
+    }
+
+    _BitScanReverse(&index, static_cast<unsigned long>(value));
+    return 31 - static_cast<int32_t>(index);
+#else
+    return CountLeadingZerosPortable(value);
+#endif
+}
+
+
 inline void SkipBytes(ByteStreamInfo& streamInfo, std::size_t count) noexcept
 {
     if (!streamInfo.rawData)
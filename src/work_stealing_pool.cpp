@@ -0,0 +1,159 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "work_stealing_pool.h"
+
+#include "parallel_for.h"
+
+#include <algorithm>
+
+using std::lock_guard;
+using std::mutex;
+using std::size_t;
+using std::unique_lock;
+
+namespace charls {
+
+WorkStealingPool::WorkStealingPool(const size_t threadCount)
+{
+    const size_t count = threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1U);
+
+    queues_.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+
+    threads_.reserve(count);
+    try
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            threads_.emplace_back(&WorkStealingPool::WorkerMain, this, i);
+        }
+    }
+    catch (...)
+    {
+        if (threads_.empty())
+            throw;
+
+        // Continue with the threads that could be started, the remaining queues will be emptied by stealing.
+    }
+}
+
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        const lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    workAvailable_.notify_all();
+
+    for (auto& thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+
+void WorkStealingPool::Run(const size_t itemCount, const std::function<void(size_t, size_t)>& action)
+{
+    if (itemCount == 0)
+        return;
+
+    const lock_guard<mutex> runLock(runMutex_);
+
+    // Give every worker a contiguous block of items, stealing will balance the load.
+    const size_t queueCount = queues_.size();
+    for (size_t i = 0; i < queueCount; ++i)
+    {
+        const size_t begin = itemCount * i / queueCount;
+        const size_t end = itemCount * (i + 1) / queueCount;
+
+        const lock_guard<mutex> lock(queues_[i]->mutex);
+        for (size_t item = begin; item < end; ++item)
+        {
+            queues_[i]->items.push_back(item);
+        }
+    }
+
+    unique_lock<mutex> lock(mutex_);
+    action_ = &action;
+    remainingItemCount_ = itemCount;
+    ++generation_;
+    workAvailable_.notify_all();
+
+    // Wait until all workers that picked up the action are done: no worker may still reference it when the next run starts.
+    workDone_.wait(lock, [this] { return remainingItemCount_ == 0 && activeWorkerCount_ == 0; });
+    action_ = nullptr;
+}
+
+
+void WorkStealingPool::WorkerMain(const size_t workerIndex)
+{
+    MarkAsPoolWorkerThread();
+    size_t seenGeneration{};
+
+    for (;;)
+    {
+        const std::function<void(size_t, size_t)>* action;
+        {
+            unique_lock<mutex> lock(mutex_);
+            workAvailable_.wait(lock, [this, seenGeneration] { return stop_ || generation_ != seenGeneration; });
+            if (stop_)
+                return;
+
+            seenGeneration = generation_;
+            action = action_;
+            if (!action)
+                continue; // The run already completed.
+
+            ++activeWorkerCount_;
+        }
+
+        size_t item;
+        while (TryGetItem(workerIndex, item))
+        {
+            (*action)(workerIndex, item);
+
+            const lock_guard<mutex> lock(mutex_);
+            --remainingItemCount_;
+        }
+
+        const lock_guard<mutex> lock(mutex_);
+        --activeWorkerCount_;
+        workDone_.notify_one();
+    }
+}
+
+
+bool WorkStealingPool::TryGetItem(const size_t workerIndex, size_t& item)
+{
+    {
+        WorkQueue& queue = *queues_[workerIndex];
+        const lock_guard<mutex> lock(queue.mutex);
+        if (!queue.items.empty())
+        {
+            item = queue.items.front();
+            queue.items.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues_.size(); ++i)
+    {
+        WorkQueue& victim = *queues_[(workerIndex + i) % queues_.size()];
+        const lock_guard<mutex> lock(victim.mutex);
+        if (!victim.items.empty())
+        {
+            item = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace charls
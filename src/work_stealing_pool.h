@@ -0,0 +1,69 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace charls {
+
+// Purpose: a fixed set of worker threads that execute batches of work items.
+// Every worker owns a queue with work items. When its own queue is empty a worker steals items
+// from the back of the queues of the other workers, which keeps all workers busy when items have different costs.
+class WorkStealingPool final
+{
+public:
+    /// <summary>
+    /// Creates the pool and starts the worker threads.
+    /// </summary>
+    /// <param name="threadCount">The number of worker threads, 0 means one thread for every hardware thread.</param>
+    explicit WorkStealingPool(std::size_t threadCount);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool(WorkStealingPool&&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool&&) = delete;
+
+    std::size_t ThreadCount() const noexcept
+    {
+        return threads_.size();
+    }
+
+    /// <summary>
+    /// Executes action(workerIndex, itemIndex) for all items and waits until all items are done.
+    /// The action is not allowed to throw, errors should be reported per item.
+    /// </summary>
+    void Run(std::size_t itemCount, const std::function<void(std::size_t, std::size_t)>& action);
+
+private:
+    struct WorkQueue final
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> items;
+    };
+
+    void WorkerMain(std::size_t workerIndex);
+    bool TryGetItem(std::size_t workerIndex, std::size_t& item);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex runMutex_;
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable workDone_;
+    const std::function<void(std::size_t, std::size_t)>* action_{};
+    std::size_t generation_{};
+    std::size_t remainingItemCount_{};
+    std::size_t activeWorkerCount_{};
+    bool stop_{};
+};
+
+} // namespace charls
@@ -3,13 +3,14 @@
 
 #include "util.h"
 
+#include "../imagegen/synthetic_image.h"
+#include "../src/cpu_dispatch.h"
 #include "../src/default_traits.h"
 #include "../src/lossless_traits.h"
 #include "../src/process_line.h"
 
 #include "bitstreamdamage.h"
 #include "compliance.h"
-#include "performance.h"
 #include "dicomsamples.h"
 
 #include <sstream>
@@ -17,7 +18,10 @@
 #include <vector>
 #include <algorithm>
 #include <array>
+#include <iterator>
+#include <numeric>
 #include <string>
+#include <thread>
 
 using std::cout;
 using std::ios;
@@ -110,6 +114,56 @@ void TestTraits8bit()
 }
 
 
+// The optimized lossless traits must give the same results as the default traits for lossless coding.
+template<typename Lossless, typename Default>
+void TestLosslessTraits()
+{
+    const Lossless traits1;
+    const Default traits2(Lossless::MAXVAL, 0);
+
+    Assert::IsTrue(traits1.LIMIT == traits2.LIMIT);
+    Assert::IsTrue(traits1.MAXVAL == traits2.MAXVAL);
+    Assert::IsTrue(traits1.RESET == traits2.RESET);
+    Assert::IsTrue(traits1.bpp == traits2.bpp);
+    Assert::IsTrue(traits1.qbpp == traits2.qbpp);
+
+    const int32_t range = Lossless::RANGE;
+    const int32_t step = std::max(1, range / 1024);
+    for (int i = -range; i < range; i += step)
+    {
+        Assert::IsTrue(traits1.ModuloRange(i) == traits2.ModuloRange(i));
+        Assert::IsTrue(traits1.ComputeErrVal(i) == traits2.ComputeErrVal(i));
+        Assert::IsTrue(traits1.CorrectPrediction(i) == traits2.CorrectPrediction(i));
+    }
+
+    for (int32_t prediction = 0; prediction < range; prediction += step)
+    {
+        for (int32_t errorValue = -range / 2; errorValue < range / 2; errorValue += step)
+        {
+            Assert::IsTrue(traits1.ComputeReconstructedSample(prediction, errorValue) == traits2.ComputeReconstructedSample(prediction, errorValue));
+        }
+    }
+
+    using PIXEL = typename Lossless::PIXEL;
+    PIXEL pixel1{};
+    PIXEL pixel2{};
+    Assert::IsTrue(traits1.IsNear(pixel1, pixel2) == traits2.IsNear(pixel1, pixel2));
+    reinterpret_cast<typename Lossless::SAMPLE*>(&pixel2)[sizeof(PIXEL) / sizeof(typename Lossless::SAMPLE) - 1] = 1;
+    Assert::IsTrue(!traits1.IsNear(pixel1, pixel2) && !traits2.IsNear(pixel1, pixel2));
+}
+
+
+void TestLosslessTraits()
+{
+    TestLosslessTraits<LosslessTraits<uint16_t, 10>, DefaultTraits<uint16_t, uint16_t>>();
+    TestLosslessTraits<LosslessTraits<Triplet<uint16_t>, 10>, DefaultTraits<uint16_t, Triplet<uint16_t>>>();
+    TestLosslessTraits<LosslessTraits<Triplet<uint16_t>, 12>, DefaultTraits<uint16_t, Triplet<uint16_t>>>();
+    TestLosslessTraits<LosslessTraits<Triplet<uint16_t>, 16>, DefaultTraits<uint16_t, Triplet<uint16_t>>>();
+    TestLosslessTraits<LosslessTraits<Quad<uint8_t>, 8>, DefaultTraits<uint8_t, Quad<uint8_t>>>();
+    TestLosslessTraits<LosslessTraits<Quad<uint16_t>, 16>, DefaultTraits<uint16_t, Quad<uint16_t>>>();
+}
+
+
 vector<uint8_t> MakeSomeNoise(size_t length, size_t bitCount, int seed)
 {
     srand(seed);
@@ -206,6 +260,52 @@ void TestFailOnTooSmallOutputBuffer()
 }
 
 
+// Images without redundancy must fit in a destination of the estimated size.
+void TestEstimatedDestinationSizeOfNoise(const frame_info& info, const interleave_mode interleaveMode, const uint32_t restartInterval = 0)
+{
+    const size_t bytesPerSample = info.bits_per_sample > 8 ? 2 : 1;
+    const vector<uint8_t> source = MakeSomeNoise(static_cast<size_t>(info.width) * info.height * info.component_count * bytesPerSample, 8, 17);
+
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleaveMode).restart_interval(restartInterval);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source));
+
+    vector<uint8_t> decoded;
+    jpegls_decoder::decode(encoded, decoded);
+    Assert::IsTrue(decoded == source);
+
+    // The component scans encoded in parallel use a buffer of the estimated size of one scan.
+    if (interleaveMode == interleave_mode::none && info.component_count > 1)
+    {
+        vector<uint8_t> parallelEncoded(encoder.reset().parallel_components(true).estimated_destination_size());
+        encoder.destination(parallelEncoded);
+        parallelEncoded.resize(encoder.encode(source));
+        Assert::IsTrue(parallelEncoded == encoded);
+    }
+}
+
+
+void TestEstimatedDestinationSize()
+{
+    TestEstimatedDestinationSizeOfNoise({512, 256, 8, 1}, interleave_mode::none);
+    TestEstimatedDestinationSizeOfNoise({512, 256, 8, 3}, interleave_mode::sample);
+    TestEstimatedDestinationSizeOfNoise({512, 256, 16, 1}, interleave_mode::none);
+    TestEstimatedDestinationSizeOfNoise({512, 256, 16, 3}, interleave_mode::line);
+
+    // Short restart intervals reset the context parameters before they can adapt to the noise.
+    TestEstimatedDestinationSizeOfNoise({64, 256, 8, 1}, interleave_mode::none, 1);
+    TestEstimatedDestinationSizeOfNoise({64, 256, 8, 1}, interleave_mode::none, 2);
+    TestEstimatedDestinationSizeOfNoise({64, 256, 16, 1}, interleave_mode::none, 2);
+    TestEstimatedDestinationSizeOfNoise({64, 256, 8, 3}, interleave_mode::none, 1);
+    TestEstimatedDestinationSizeOfNoise({64, 256, 8, 3}, interleave_mode::sample, 2);
+    TestEstimatedDestinationSizeOfNoise({1, 256, 16, 3}, interleave_mode::line, 1);
+    TestEstimatedDestinationSizeOfNoise({512, 256, 16, 1}, interleave_mode::none, 16);
+    TestEstimatedDestinationSizeOfNoise({1, 1, 16, 3}, interleave_mode::none);
+}
+
+
 void TestBgra()
 {
     char input[] = "RGBARGBARGBARGBA1234";
@@ -317,6 +417,990 @@ void TestDecodeRect()
 }
 
 
+void TestRestartInterval(const vector<uint8_t>& source, const frame_info& info, interleave_mode mode, int nearLossless, uint32_t restartInterval)
+{
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(mode).near_lossless(nearLossless).restart_interval(restartInterval);
+
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source));
+
+    size_t restartMarkerCount{};
+    for (size_t i = 1; i < encoded.size(); ++i)
+    {
+        if (encoded[i - 1] == 0xFF && encoded[i] >= 0xD0 && encoded[i] <= 0xD7)
+        {
+            ++restartMarkerCount;
+        }
+    }
+    Assert::IsTrue(restartMarkerCount == (info.height - 1) / restartInterval);
+
+    // Full image decoding with the parallel mode will decode the restart intervals in parallel.
+    jpegls_decoder decoder{encoded};
+    vector<uint8_t> decoded(decoder.parallel_decoding(true).read_header().destination_size());
+    decoder.decode(decoded);
+    vector<uint8_t> sequentialDecoded;
+    jpegls_decoder::decode(encoded, sequentialDecoded);
+    Assert::IsTrue(decoded == sequentialDecoded);
+    Assert::IsTrue(decoded.size() == source.size());
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        Assert::IsTrue(std::abs(source[i] - decoded[i]) <= nearLossless);
+    }
+
+    // Decoding a rect will decode the restart intervals sequentially.
+    const auto components = static_cast<size_t>(info.component_count);
+    const JlsRect rect{0, 1, static_cast<int32_t>(info.width), static_cast<int32_t>(info.height) - 1};
+    vector<uint8_t> decodedRect(static_cast<size_t>(rect.Width) * rect.Height * components);
+    const error_code error = JpegLsDecodeRect(decodedRect.data(), decodedRect.size(), encoded.data(), encoded.size(), rect, nullptr, nullptr);
+    Assert::IsTrue(!error);
+
+    Assert::IsTrue(std::equal(decodedRect.cbegin(), decodedRect.cend(), decoded.cbegin() + static_cast<ptrdiff_t>(info.width * components)));
+}
+
+
+void TestRestartInterval()
+{
+    const vector<uint8_t> mono = ReadFile("test/lena8b.raw");
+    const frame_info monoInfo{512, 512, 8, 1};
+    TestRestartInterval(mono, monoInfo, interleave_mode::none, 0, 1);
+    TestRestartInterval(mono, monoInfo, interleave_mode::none, 0, 7);
+    TestRestartInterval(mono, monoInfo, interleave_mode::none, 3, 64);
+    TestRestartInterval(mono, monoInfo, interleave_mode::none, 0, 512);
+
+    const vector<uint8_t> color = ReadFile("test/conformance/TEST8.PPM", 15);
+    const frame_info colorInfo{256, 256, 8, 3};
+    TestRestartInterval(color, colorInfo, interleave_mode::line, 0, 10);
+    TestRestartInterval(color, colorInfo, interleave_mode::sample, 0, 10);
+    TestRestartInterval(color, colorInfo, interleave_mode::sample, 2, 100);
+}
+
+
+void TestPlanarComponents(uint32_t restartInterval)
+{
+    const vector<uint8_t> interleaved = ReadFile("test/conformance/TEST8.PPM", 15);
+    const frame_info info{256, 256, 8, 3};
+    const size_t planeSize = static_cast<size_t>(info.width) * info.height;
+
+    vector<uint8_t> planar(interleaved.size());
+    for (size_t i = 0; i < planeSize; ++i)
+    {
+        for (size_t component = 0; component < 3; ++component)
+        {
+            planar[component * planeSize + i] = interleaved[i * 3 + component];
+        }
+    }
+
+    // The scans encoded in parallel should be the same as the scans encoded in order.
+    jpegls_encoder encoder;
+    encoder.frame_info(info).restart_interval(restartInterval).parallel_components(true);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(planar));
+
+    jpegls_encoder sequentialEncoder;
+    sequentialEncoder.frame_info(info).restart_interval(restartInterval);
+    vector<uint8_t> sequentialEncoded(sequentialEncoder.estimated_destination_size());
+    sequentialEncoder.destination(sequentialEncoded);
+    sequentialEncoded.resize(sequentialEncoder.encode(planar));
+    Assert::IsTrue(encoded == sequentialEncoded);
+
+    JlsParameters params{};
+    params.width = static_cast<int32_t>(info.width);
+    params.height = static_cast<int32_t>(info.height);
+    params.bitsPerSample = info.bits_per_sample;
+    params.components = info.component_count;
+    if (restartInterval == 0)
+    {
+        stringstream encodedStream;
+        size_t bytesWritten{};
+        const error_code error = JpegLsEncodeStream({encodedStream.rdbuf(), nullptr, 0}, bytesWritten, FromByteArrayConst(planar.data(), planar.size()), params);
+        Assert::IsTrue(!error);
+        const string streamEncoded{encodedStream.str()};
+        Assert::IsTrue(encoded == vector<uint8_t>(streamEncoded.cbegin(), streamEncoded.cend()));
+    }
+
+    jpegls_decoder decoder{encoded};
+    vector<uint8_t> decoded(decoder.parallel_decoding(true).read_header().destination_size());
+    decoder.decode(decoded);
+    Assert::IsTrue(decoded == planar);
+
+    vector<uint8_t> sequentialDecoded;
+    jpegls_decoder::decode(encoded, sequentialDecoded);
+    Assert::IsTrue(sequentialDecoded == planar);
+}
+
+
+void TestBatch()
+{
+    constexpr size_t frameCount = 37;
+
+    vector<vector<uint8_t>> sources(frameCount);
+    vector<vector<uint8_t>> encoded(frameCount);
+    vector<batch_encode_frame> encodeFrames(frameCount);
+    for (size_t i = 0; i < frameCount; ++i)
+    {
+        const frame_info info{static_cast<uint32_t>(16 + i * 7), static_cast<uint32_t>(9 + i * 3), 8, 1};
+        sources[i] = MakeSomeNoise(static_cast<size_t>(info.width) * info.height, 8, static_cast<int>(i));
+        encoded[i].resize(sources[i].size() * 2 + 1024);
+        encodeFrames[i] = {sources[i].data(), sources[i].size(), 0, info, interleave_mode::none, 0, encoded[i].data(), encoded[i].size(), 0, jpegls_errc::unexpected_failure};
+    }
+
+    // A too small destination buffer should only fail the frame itself.
+    encodeFrames[5].destination_size_bytes = 10;
+
+    const jpegls_batch batch(4);
+    batch.encode(encodeFrames);
+
+    vector<vector<uint8_t>> decoded(frameCount);
+    vector<batch_decode_frame> decodeFrames(frameCount);
+    for (size_t i = 0; i < frameCount; ++i)
+    {
+        if (i == 5)
+        {
+            Assert::IsTrue(encodeFrames[i].result == jpegls_errc::destination_buffer_too_small);
+            continue;
+        }
+
+        Assert::IsTrue(encodeFrames[i].result == jpegls_errc::success);
+        decoded[i].resize(sources[i].size());
+        decodeFrames[i] = {encoded[i].data(), encodeFrames[i].bytes_written, decoded[i].data(), decoded[i].size(), 0, jpegls_errc::unexpected_failure};
+    }
+
+    batch.decode(decodeFrames);
+
+    for (size_t i = 0; i < frameCount; ++i)
+    {
+        if (i == 5)
+        {
+            Assert::IsTrue(decodeFrames[i].result != jpegls_errc::success);
+            continue;
+        }
+
+        Assert::IsTrue(decodeFrames[i].result == jpegls_errc::success);
+        Assert::IsTrue(decoded[i] == sources[i]);
+    }
+}
+
+
+void TestReset()
+{
+    jpegls_encoder encoder;
+    jpegls_decoder decoder;
+
+    // Alternate the frame sizes to test the reuse and the re-creation of the cached codecs.
+    for (int i = 0; i < 6; ++i)
+    {
+        const frame_info info{static_cast<uint32_t>(i % 2 == 0 ? 64 : 33), static_cast<uint32_t>(i % 2 == 0 ? 48 : 21), 8, 3};
+        const vector<uint8_t> source = MakeSomeNoise(static_cast<size_t>(info.width) * info.height * info.component_count, 8, i);
+
+        encoder.reset()
+            .frame_info(info)
+            .near_lossless(i % 3)
+            .restart_interval(i < 3 ? 0 : 8);
+        vector<uint8_t> encoded(source.size() * 2 + 1024);
+        encoder.destination(encoded);
+        encoded.resize(encoder.encode(source));
+
+        jpegls_encoder newEncoder;
+        newEncoder.frame_info(info)
+            .near_lossless(i % 3)
+            .restart_interval(i < 3 ? 0 : 8);
+        vector<uint8_t> expected(source.size() * 2 + 1024);
+        newEncoder.destination(expected);
+        expected.resize(newEncoder.encode(source));
+        Assert::IsTrue(encoded == expected);
+
+        decoder.reset()
+            .source(encoded)
+            .read_header();
+        vector<uint8_t> decoded(decoder.destination_size());
+        decoder.decode(decoded);
+
+        vector<uint8_t> decodedExpected;
+        jpegls_decoder::decode(encoded, decodedExpected);
+        Assert::IsTrue(decoded == decodedExpected);
+        if (i % 3 == 0)
+        {
+            Assert::IsTrue(decoded == source);
+        }
+    }
+}
+
+
+// Encoding and decoding a strip of rows at a time with callbacks must give the same result as the buffer based functions.
+void TestRowCallbacks(const frame_info& info, interleave_mode interleaveMode, color_transformation colorTransformation, size_t stripRows)
+{
+    const size_t bytesPerSample = info.bits_per_sample > 8 ? 2 : 1;
+    vector<uint8_t> source = MakeSomeNoise(static_cast<size_t>(info.width) * info.height * info.component_count * bytesPerSample, 8, 7);
+    if (bytesPerSample == 2)
+    {
+        for (size_t i = 1; i < source.size(); i += 2)
+        {
+            source[i] &= static_cast<uint8_t>((1 << (info.bits_per_sample - 8)) - 1);
+        }
+    }
+
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleaveMode).color_transformation(colorTransformation);
+    vector<uint8_t> expected(encoder.estimated_destination_size());
+    encoder.destination(expected);
+    expected.resize(encoder.encode(source));
+
+    const size_t rowSize = info.width * bytesPerSample * (interleaveMode == interleave_mode::none ? 1 : info.component_count);
+    vector<uint8_t> strip(rowSize * stripRows);
+    size_t sourcePosition{};
+    size_t lastRowsSize{};
+    auto rowSource = [&](void* rows, uint32_t rowCount) {
+        Assert::IsTrue(rowCount <= stripRows);
+        memcpy(rows, source.data() + sourcePosition, rowCount * rowSize);
+        sourcePosition += rowCount * rowSize;
+        lastRowsSize = rowCount * rowSize;
+    };
+
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.reset().destination(encoded);
+    encoded.resize(encoder.encode_rows(strip.data(), strip.size(), rowSource));
+    Assert::IsTrue(sourcePosition == source.size());
+    Assert::IsTrue(encoded == expected);
+
+    // The encoder only reads the strip: it still holds the last rows passed by the callback.
+    Assert::IsTrue(memcmp(strip.data(), source.data() + source.size() - lastRowsSize, lastRowsSize) == 0);
+
+    vector<uint8_t> decoded;
+    auto rowHandler = [&](const void* rows, uint32_t rowCount) {
+        Assert::IsTrue(rowCount <= stripRows);
+        decoded.insert(decoded.end(), static_cast<const uint8_t*>(rows), static_cast<const uint8_t*>(rows) + rowCount * rowSize);
+    };
+
+    jpegls_decoder decoder{encoded};
+    decoder.read_header();
+    decoder.decode_rows(strip.data(), strip.size(), rowHandler);
+    vector<uint8_t> decodedExpected;
+    jpegls_decoder::decode(encoded, decodedExpected);
+    Assert::IsTrue(decoded == decodedExpected);
+
+    // A callback that fails must abort the operation.
+    auto failingHandler = [](const void*, uint32_t) { throw std::runtime_error("abort"); };
+    decoder.reset().source(encoded).read_header();
+    error_code error;
+    try
+    {
+        decoder.decode_rows(strip.data(), strip.size(), failingHandler);
+    }
+    catch (const jpegls_error& e)
+    {
+        error = e.code();
+    }
+    Assert::IsTrue(error == jpegls_errc::callback_failed);
+}
+
+
+void TestRowCallbacks()
+{
+    TestRowCallbacks({61, 33, 8, 1}, interleave_mode::none, color_transformation::none, 4);
+    TestRowCallbacks({61, 33, 12, 1}, interleave_mode::none, color_transformation::none, 1);
+    TestRowCallbacks({61, 33, 16, 3}, interleave_mode::none, color_transformation::none, 5);
+    TestRowCallbacks({61, 33, 8, 3}, interleave_mode::line, color_transformation::none, 7);
+    TestRowCallbacks({61, 33, 8, 3}, interleave_mode::sample, color_transformation::hp1, 3);
+    TestRowCallbacks({61, 33, 8, 4}, interleave_mode::sample, color_transformation::none, 40);
+}
+
+
+// Decoding a partial source that is extended a chunk at a time must give the same result as decoding the complete source.
+void TestPartialSource(const frame_info& info, interleave_mode interleaveMode, uint32_t restartInterval, size_t chunkSize)
+{
+    const size_t bytesPerSample = info.bits_per_sample > 8 ? 2 : 1;
+    const vector<uint8_t> source = MakeSomeNoise(static_cast<size_t>(info.width) * info.height * info.component_count * bytesPerSample, 6, 3);
+
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleaveMode).restart_interval(restartInterval);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source));
+
+    vector<uint8_t> expected;
+    jpegls_decoder::decode(encoded, expected);
+
+    // The received data is stored in a vector that grows: the decoder must handle a moved source buffer.
+    vector<uint8_t> received(encoded.cbegin(), encoded.cbegin() + chunkSize);
+    const auto receiveNextChunk = [&]() {
+        Assert::IsTrue(received.size() < encoded.size());
+        const size_t size = std::min(received.size() + chunkSize, encoded.size());
+        received.insert(received.end(), encoded.cbegin() + received.size(), encoded.cbegin() + size);
+    };
+
+    jpegls_decoder decoder;
+    decoder.partial_source(received.data(), received.size());
+    error_code error;
+    for (decoder.read_header(error); error == jpegls_errc::need_more_data; decoder.read_header(error))
+    {
+        receiveNextChunk();
+        decoder.extend_source(received.data(), received.size());
+    }
+    Assert::IsTrue(!error);
+
+    vector<uint8_t> decoded(decoder.destination_size());
+    int needMoreDataCount{};
+    for (decoder.decode(decoded.data(), decoded.size(), 0, error); error == jpegls_errc::need_more_data; decoder.decode(decoded.data(), decoded.size(), 0, error))
+    {
+        ++needMoreDataCount;
+        receiveNextChunk();
+        decoder.extend_source(received.data(), received.size());
+    }
+    Assert::IsTrue(!error);
+    Assert::IsTrue(needMoreDataCount > 0);
+    Assert::IsTrue(decoded == expected);
+
+    // The rows that are completed are passed to the callback before more data is needed.
+    received.assign(encoded.cbegin(), encoded.cbegin() + encoded.size() / 2);
+    decoder.reset().partial_source(received.data(), received.size()).read_header();
+    const size_t rowSize = info.width * bytesPerSample * (interleaveMode == interleave_mode::none ? 1 : info.component_count);
+    vector<uint8_t> strip(rowSize * 2);
+    vector<uint8_t> decodedRows;
+    auto rowHandler = [&](const void* rows, uint32_t rowCount) {
+        decodedRows.insert(decodedRows.end(), static_cast<const uint8_t*>(rows), static_cast<const uint8_t*>(rows) + rowCount * rowSize);
+    };
+    try
+    {
+        decoder.decode_rows(strip.data(), strip.size(), rowHandler);
+        Assert::IsTrue(false);
+    }
+    catch (const jpegls_error& e)
+    {
+        Assert::IsTrue(e.code() == jpegls_errc::need_more_data);
+    }
+    Assert::IsTrue(!decodedRows.empty() && decodedRows.size() < expected.size());
+
+    decoder.extend_source(encoded.data(), encoded.size());
+    decoder.decode_rows(strip.data(), strip.size(), rowHandler);
+    Assert::IsTrue(decodedRows == expected);
+
+    // The codecs cached by the partial decode are reused by a (parallel) decode of a complete source.
+    decoder.reset().parallel_decoding(true).source(encoded).read_header();
+    std::fill(decoded.begin(), decoded.end(), uint8_t{});
+    decoder.decode(decoded);
+    Assert::IsTrue(decoded == expected);
+}
+
+
+void TestPartialSource()
+{
+    TestPartialSource({64, 48, 8, 1}, interleave_mode::none, 0, 1);
+    TestPartialSource({64, 48, 8, 1}, interleave_mode::none, 5, 7);
+    TestPartialSource({64, 48, 16, 1}, interleave_mode::none, 0, 100);
+    TestPartialSource({64, 48, 8, 3}, interleave_mode::none, 0, 33);
+    TestPartialSource({64, 48, 8, 3}, interleave_mode::line, 4, 50);
+    TestPartialSource({64, 48, 8, 3}, interleave_mode::sample, 0, 17);
+    TestPartialSource({64, 48, 16, 4}, interleave_mode::line, 0, 64);
+}
+
+
+// Decoding a region of interest must give the same pixels as the matching part of the complete image.
+void TestDecodeRegion(const frame_info& info, interleave_mode interleaveMode, const charls_rect& region)
+{
+    const size_t bytesPerSample = info.bits_per_sample > 8 ? 2 : 1;
+    const vector<uint8_t> source = MakeSomeNoise(static_cast<size_t>(info.width) * info.height * info.component_count * bytesPerSample, 6, 5);
+
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleaveMode);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source));
+
+    vector<uint8_t> decoded;
+    jpegls_decoder::decode(encoded, decoded);
+
+    const size_t planeCount = interleaveMode == interleave_mode::none ? info.component_count : 1;
+    const size_t pixelSize = bytesPerSample * (interleaveMode == interleave_mode::none ? 1 : info.component_count);
+    vector<uint8_t> expected;
+    for (size_t plane = 0; plane < planeCount; ++plane)
+    {
+        for (size_t y = region.y; y < region.y + region.height; ++y)
+        {
+            const auto row = decoded.cbegin() + static_cast<ptrdiff_t>(((plane * info.height + y) * info.width + region.x) * pixelSize);
+            expected.insert(expected.end(), row, row + static_cast<ptrdiff_t>(region.width * pixelSize));
+        }
+    }
+
+    jpegls_decoder decoder{encoded};
+    decoder.read_header().region(region);
+    vector<uint8_t> decodedRegion(decoder.destination_size());
+    Assert::IsTrue(decodedRegion.size() == expected.size());
+    decoder.decode(decodedRegion);
+    Assert::IsTrue(decodedRegion == expected);
+
+    vector<uint8_t> strip(region.width * pixelSize * 3);
+    vector<uint8_t> decodedRows;
+    auto rowHandler = [&](const void* rows, uint32_t rowCount) {
+        decodedRows.insert(decodedRows.end(), static_cast<const uint8_t*>(rows), static_cast<const uint8_t*>(rows) + rowCount * region.width * pixelSize);
+    };
+    decoder.reset().source(encoded).read_header().region(region).decode_rows(strip.data(), strip.size(), rowHandler);
+    Assert::IsTrue(decodedRows == expected);
+}
+
+
+void TestDecodeRegion()
+{
+    TestDecodeRegion({64, 48, 8, 1}, interleave_mode::none, {0, 0, 64, 10});
+    TestDecodeRegion({64, 48, 8, 1}, interleave_mode::none, {5, 7, 20, 11});
+    TestDecodeRegion({64, 48, 16, 1}, interleave_mode::none, {0, 40, 64, 8});
+    TestDecodeRegion({64, 48, 8, 3}, interleave_mode::none, {3, 0, 30, 12});
+    TestDecodeRegion({64, 48, 8, 3}, interleave_mode::line, {0, 1, 64, 1});
+    TestDecodeRegion({64, 48, 8, 3}, interleave_mode::sample, {60, 20, 4, 5});
+
+    const vector<uint8_t> source(static_cast<size_t>(16) * 16);
+    const vector<uint8_t> encoded = jpegls_encoder::encode(source, {16, 16, 8, 1});
+    jpegls_decoder decoder{encoded};
+    decoder.read_header();
+    for (const charls_rect& invalid : {charls_rect{0, 0, 0, 1}, charls_rect{0, 0, 1, 0}, charls_rect{16, 0, 1, 1}, charls_rect{0, 8, 16, 9}})
+    {
+        try
+        {
+            decoder.region(invalid);
+            Assert::IsTrue(false);
+        }
+        catch (const jpegls_error& e)
+        {
+            Assert::IsTrue(e.code() == jpegls_errc::invalid_argument);
+        }
+    }
+}
+
+
+// Decoding a region with a row index must give the same pixels as decoding the region without the index.
+void TestRowIndex(const frame_info& info, interleave_mode interleaveMode, uint32_t restartInterval, uint32_t rowInterval)
+{
+    const size_t bytesPerSample = info.bits_per_sample > 8 ? 2 : 1;
+    const vector<uint8_t> source = MakeSomeNoise(static_cast<size_t>(info.width) * info.height * info.component_count * bytesPerSample, 6, 7);
+
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleaveMode).restart_interval(restartInterval);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source));
+
+    jpegls_decoder decoder{encoded};
+    decoder.read_header().build_row_index(rowInterval);
+
+    // The decoder is ready to decode the complete frame after the index has been built.
+    vector<uint8_t> decoded(decoder.destination_size());
+    decoder.decode(decoded);
+    vector<uint8_t> expected;
+    jpegls_decoder::decode(encoded, expected);
+    Assert::IsTrue(decoded == expected);
+
+    for (const charls_rect& region : {charls_rect{0, rowInterval, info.width, 1}, charls_rect{3, rowInterval + 1, info.width - 5, rowInterval * 2},
+                                      charls_rect{0, info.height - 1, 7, 1}, charls_rect{1, 0, 5, 3}})
+    {
+        vector<uint8_t> decodedWithIndex(decoder.rewind().region(region).destination_size());
+        decoder.decode(decodedWithIndex);
+
+        jpegls_decoder decoderWithoutIndex{encoded};
+        vector<uint8_t> decodedWithoutIndex(decoderWithoutIndex.read_header().region(region).destination_size());
+        decoderWithoutIndex.decode(decodedWithoutIndex);
+        Assert::IsTrue(decodedWithIndex == decodedWithoutIndex);
+    }
+}
+
+
+void TestRowIndex()
+{
+    TestRowIndex({64, 48, 8, 1}, interleave_mode::none, 0, 8);
+    TestRowIndex({64, 48, 16, 1}, interleave_mode::none, 0, 5);
+    TestRowIndex({64, 48, 8, 1}, interleave_mode::none, 6, 4);
+    TestRowIndex({64, 48, 8, 3}, interleave_mode::none, 0, 7);
+    TestRowIndex({64, 48, 8, 3}, interleave_mode::line, 5, 3);
+    TestRowIndex({64, 48, 8, 4}, interleave_mode::sample, 0, 10);
+
+    // Decoding a region with the index doesn't read the scan data before the last indexed row above the region.
+    const frame_info info{64, 48, 8, 1};
+    const vector<uint8_t> source = MakeSomeNoise(static_cast<size_t>(info.width) * info.height, 8, 9);
+    vector<uint8_t> encoded = jpegls_encoder::encode(source, info);
+    const charls_rect region{0, 40, 64, 8};
+    vector<uint8_t> expected;
+    jpegls_decoder decoder{encoded};
+    expected.resize(decoder.read_header().region(region).destination_size());
+    decoder.decode(expected);
+
+    decoder.reset().source(encoded).read_header().build_row_index(16);
+    const std::array<uint8_t, 2> startOfScanMarker{0xFF, 0xDA};
+    const auto startOfScan = std::search(encoded.begin(), encoded.end(), startOfScanMarker.cbegin(), startOfScanMarker.cend());
+    const auto scanData = startOfScan + 2 + ((startOfScan[2] << 8) | startOfScan[3]);
+    std::fill(scanData, scanData + 64, uint8_t{});
+
+    vector<uint8_t> decoded(decoder.rewind().region(region).destination_size());
+    decoder.decode(decoded);
+    Assert::IsTrue(decoded == expected);
+
+    // Setting a source removes the index: a reused buffer with a different frame must not be decoded with stale rows.
+    const vector<uint8_t> otherSource = MakeSomeNoise(source.size(), 8, 10);
+    const vector<uint8_t> otherEncoded = jpegls_encoder::encode(otherSource, info);
+    vector<uint8_t> buffer(std::max(encoded.size(), otherEncoded.size()));
+    encoded = jpegls_encoder::encode(source, info);
+    std::copy(encoded.cbegin(), encoded.cend(), buffer.begin());
+    decoder.reset().source(buffer).read_header().build_row_index(16);
+    std::copy(otherEncoded.cbegin(), otherEncoded.cend(), buffer.begin());
+    decoded.resize(decoder.reset().source(buffer).read_header().region(region).destination_size());
+    decoder.decode(decoded);
+    Assert::IsTrue(std::equal(decoded.cbegin(), decoded.cend(), otherSource.cbegin() + 40 * 64));
+}
+
+
+// A preview must be equal to the box filtered (and windowed) full resolution image.
+void TestPreview(const frame_info& info, interleave_mode interleaveMode, const preview_options& options)
+{
+    const size_t bytesPerSample = info.bits_per_sample > 8 ? 2 : 1;
+    const size_t sampleCount = static_cast<size_t>(info.width) * info.height * info.component_count;
+    vector<uint8_t> source = MakeSomeNoise(sampleCount * bytesPerSample, 6, 11);
+    if (bytesPerSample == 2)
+    {
+        // Smooth noise in the range of the bit depth, which makes windowing meaningful.
+        vector<uint16_t> samples(sampleCount);
+        for (size_t i = 0; i < sampleCount; ++i)
+        {
+            samples[i] = static_cast<uint16_t>(((i % info.width) << (info.bits_per_sample - 6)) + source[i * 2]) & ((1 << info.bits_per_sample) - 1);
+        }
+        memcpy(source.data(), samples.data(), source.size());
+    }
+
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleaveMode);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source));
+
+    vector<uint8_t> decoded;
+    jpegls_decoder::decode(encoded, decoded);
+
+    const uint32_t scale = options.scale_factor;
+    const uint32_t previewWidth = (info.width + scale - 1) / scale;
+    const uint32_t previewHeight = (info.height + scale - 1) / scale;
+    const bool window = options.window_high > options.window_low;
+    const auto components = static_cast<size_t>(info.component_count);
+    const size_t planeCount = interleaveMode == interleave_mode::none ? components : 1;
+    const size_t samplesPerPixel = interleaveMode == interleave_mode::none ? 1 : components;
+
+    vector<uint8_t> expected;
+    for (size_t plane = 0; plane < planeCount; ++plane)
+    {
+        for (uint32_t y = 0; y < previewHeight; ++y)
+        {
+            for (uint32_t x = 0; x < previewWidth; ++x)
+            {
+                for (size_t i = 0; i < samplesPerPixel; ++i)
+                {
+                    uint32_t sum{};
+                    uint32_t count{};
+                    for (uint32_t sy = y * scale; sy < std::min((y + 1) * scale, info.height); ++sy)
+                    {
+                        for (uint32_t sx = x * scale; sx < std::min((x + 1) * scale, info.width); ++sx)
+                        {
+                            const size_t index = ((plane * info.height + sy) * info.width + sx) * samplesPerPixel + i;
+                            sum += bytesPerSample == 1 ? decoded[index] : reinterpret_cast<const uint16_t*>(decoded.data())[index];
+                            ++count;
+                        }
+                    }
+
+                    uint32_t value = (sum + count / 2) / count;
+                    if (window)
+                    {
+                        value = value <= options.window_low ? 0 : value >= options.window_high ? 255 :
+                            ((value - options.window_low) * 255 + (options.window_high - options.window_low) / 2) / (options.window_high - options.window_low);
+                    }
+
+                    expected.push_back(static_cast<uint8_t>(value));
+                    if (!window && bytesPerSample == 2)
+                    {
+                        expected.push_back(static_cast<uint8_t>(value >> 8));
+                    }
+                }
+            }
+        }
+    }
+
+    jpegls_decoder decoder{encoded};
+    decoder.read_header().preview(options);
+    vector<uint8_t> preview(decoder.destination_size());
+    Assert::IsTrue(preview.size() == expected.size());
+    decoder.decode(preview);
+    Assert::IsTrue(preview == expected);
+}
+
+
+void TestPreview()
+{
+    TestPreview({61, 33, 8, 1}, interleave_mode::none, {2, 0, 0});
+    TestPreview({64, 48, 8, 1}, interleave_mode::none, {1, 0, 0});
+    TestPreview({64, 48, 12, 1}, interleave_mode::none, {4, 0, 0});
+    TestPreview({63, 47, 16, 1}, interleave_mode::none, {4, 1000, 50000});
+    TestPreview({61, 33, 8, 3}, interleave_mode::none, {3, 0, 0});
+    TestPreview({61, 33, 8, 3}, interleave_mode::line, {2, 0, 0});
+    TestPreview({61, 33, 12, 3}, interleave_mode::sample, {4, 100, 3000});
+    TestPreview({64, 48, 8, 4}, interleave_mode::sample, {8, 0, 0});
+
+    const vector<uint8_t> encoded = jpegls_encoder::encode(MakeSomeNoise(256, 8, 1), {16, 16, 8, 1});
+    jpegls_decoder decoder{encoded};
+    decoder.read_header();
+    for (const preview_options& invalid : {preview_options{0, 0, 0}, preview_options{256, 0, 0}, preview_options{2, 10, 5}, preview_options{2, 5, 5}})
+    {
+        try
+        {
+            decoder.preview(invalid);
+            Assert::IsTrue(false);
+        }
+        catch (const jpegls_error& e)
+        {
+            Assert::IsTrue(e.code() == jpegls_errc::invalid_argument);
+        }
+    }
+}
+
+
+// Lossless round trip of the formats that are coded with the optimized lossless traits.
+void TestLosslessRoundTrip(const frame_info& info, interleave_mode interleaveMode, color_transformation colorTransformation = color_transformation::none)
+{
+    const size_t sampleCount = static_cast<size_t>(info.width) * info.height * info.component_count;
+    const vector<uint8_t> noise = MakeSomeNoise(sampleCount, 8, 13);
+    vector<uint16_t> source(sampleCount);
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        // A gradient with noise and runs, the last component (alpha) only differs at some pixels.
+        const auto x = static_cast<int32_t>(i / info.component_count % info.width);
+        const int32_t value = x < 20 ? 0 : (x << (info.bits_per_sample - 6)) + (noise[i] & 0xF);
+        source[i] = static_cast<uint16_t>(value & ((1 << info.bits_per_sample) - 1));
+    }
+
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleaveMode).color_transformation(colorTransformation);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    if (info.bits_per_sample > 8)
+    {
+        encoded.resize(encoder.encode(source));
+        vector<uint16_t> decoded(source.size());
+        jpegls_decoder{encoded}.read_header().decode(decoded);
+        Assert::IsTrue(decoded == source);
+    }
+    else
+    {
+        vector<uint8_t> source8(source.cbegin(), source.cend());
+        if (info.component_count == 4)
+        {
+            source8[static_cast<size_t>(info.width) * 4 + 3] = 255; // alpha differs inside a run of the other components.
+        }
+        encoded.resize(encoder.encode(source8));
+        vector<uint8_t> decoded;
+        jpegls_decoder::decode(encoded, decoded);
+        Assert::IsTrue(decoded == source8);
+    }
+}
+
+
+void TestLosslessRoundTrip()
+{
+    TestLosslessRoundTrip({61, 33, 10, 1}, interleave_mode::none);
+    TestLosslessRoundTrip({61, 33, 10, 3}, interleave_mode::line);
+    TestLosslessRoundTrip({61, 33, 10, 3}, interleave_mode::sample);
+    TestLosslessRoundTrip({61, 33, 12, 3}, interleave_mode::sample);
+    TestLosslessRoundTrip({61, 33, 16, 3}, interleave_mode::sample);
+    TestLosslessRoundTrip({61, 33, 16, 4}, interleave_mode::sample);
+    TestLosslessRoundTrip({61, 33, 8, 4}, interleave_mode::sample);
+
+    // The color transformation must also be applied by the encoder, not only signaled in the header.
+    TestLosslessRoundTrip({61, 33, 8, 3}, interleave_mode::sample, color_transformation::hp1);
+    TestLosslessRoundTrip({61, 33, 8, 3}, interleave_mode::line, color_transformation::hp2);
+    TestLosslessRoundTrip({61, 33, 16, 3}, interleave_mode::sample, color_transformation::hp3);
+}
+
+
+// Every family of the image generator must round trip, also the noise images that need more than the uncompressed size.
+void TestSyntheticImages()
+{
+    for (const auto family : charls_imagegen::image_families)
+    {
+        for (const int32_t bitsPerSample : {2, 8, 12, 16})
+        {
+            for (const int32_t componentCount : {1, 3})
+            {
+                const frame_info info{97, 61, bitsPerSample, componentCount};
+                const vector<uint8_t> source = charls_imagegen::generate_image({family, info.width, info.height, bitsPerSample, componentCount, false, 5});
+                const vector<uint8_t> encoded = jpegls_encoder::encode(source, info, componentCount == 1 ? interleave_mode::none : interleave_mode::sample);
+                vector<uint8_t> decoded;
+                jpegls_decoder::decode(encoded, decoded);
+                Assert::IsTrue(decoded == source);
+            }
+        }
+    }
+
+    // The images must be the same on every platform: compare a hash of the sample values with the known values.
+    constexpr array<uint32_t, 5> expectedHashes{{0x6B0C13E3, 0x1E98C678, 0x1CD09041, 0x1A5A33AF, 0x157391C5}};
+    for (size_t i = 0; i < expectedHashes.size(); ++i)
+    {
+        const vector<uint8_t> pixels = charls_imagegen::generate_image({charls_imagegen::image_families[i], 64, 48, 12, 3, false, 1});
+        uint32_t hash = 2166136261;
+        for (size_t j = 0; j < pixels.size(); j += 2)
+        {
+            uint16_t sample;
+            memcpy(&sample, &pixels[j], sizeof sample);
+            hash = (hash ^ sample) * 16777619;
+        }
+        Assert::IsTrue(hash == expectedHashes[i]);
+    }
+}
+
+
+// The encoder and decoder make the same modeling decisions: both must count the same regular mode samples and runs.
+void TestStatistics(const uint32_t componentCount, const interleave_mode interleaveMode)
+{
+    const frame_info info{97, 61, 8, static_cast<int32_t>(componentCount)};
+    const vector<uint8_t> source = charls_imagegen::generate_image({charls_imagegen::image_family::medical, info.width, info.height, 8, info.component_count, false, 3});
+
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleaveMode);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source));
+
+    jpegls_decoder decoder;
+    decoder.source(encoded).read_header();
+    vector<uint8_t> decoded(decoder.destination_size());
+    decoder.decode(decoded);
+
+    coding_statistics encoderStatistics{};
+    try
+    {
+        encoderStatistics = encoder.statistics();
+    }
+    catch (const jpegls_error& e)
+    {
+        // CharLS has been built without the statistics.
+        Assert::IsTrue(e.code() == jpegls_errc::statistics_not_enabled);
+        return;
+    }
+
+    const coding_statistics decoderStatistics = decoder.statistics();
+    for (const auto& statistics : {encoderStatistics, decoderStatistics})
+    {
+        Assert::IsTrue(statistics.line_count == (interleaveMode == interleave_mode::none ? componentCount : 1) * info.height);
+        Assert::IsTrue(statistics.regular_mode_sample_count / (interleaveMode == interleave_mode::sample ? componentCount : 1) +
+                           statistics.run_mode_pixel_count + statistics.run_interruption_count ==
+                       static_cast<uint64_t>(info.width) * info.height * (interleaveMode == interleave_mode::sample ? 1 : componentCount));
+        Assert::IsTrue(std::accumulate(std::begin(statistics.run_length_histogram), std::end(statistics.run_length_histogram), uint64_t{}) == statistics.run_count);
+        Assert::IsTrue(std::accumulate(std::begin(statistics.golomb_k_histogram), std::end(statistics.golomb_k_histogram), uint64_t{}) == statistics.regular_mode_sample_count);
+        Assert::IsTrue(statistics.run_count != 0 && statistics.regular_mode_sample_count != 0);
+        Assert::IsTrue(statistics.maximum_line_byte_count != 0 && (statistics.coded_bit_count + 7) / 8 <= encoded.size());
+    }
+
+    Assert::IsTrue(encoderStatistics.regular_mode_sample_count == decoderStatistics.regular_mode_sample_count);
+    Assert::IsTrue(encoderStatistics.run_interruption_count == decoderStatistics.run_interruption_count);
+    Assert::IsTrue(encoderStatistics.stuffed_byte_count == decoderStatistics.stuffed_byte_count);
+    Assert::IsTrue(decoderStatistics.golomb_table_hit_count + decoderStatistics.golomb_table_miss_count == decoderStatistics.regular_mode_sample_count);
+    Assert::IsTrue(decoderStatistics.bit_reader_fill_count >= decoderStatistics.bit_reader_slow_fill_count && decoderStatistics.bit_reader_fill_count != 0);
+
+    // Reset clears the counters, also of the cached codecs that are reused.
+    Assert::IsTrue(encoder.reset().statistics().line_count == 0);
+    Assert::IsTrue(decoder.reset().statistics().line_count == 0);
+    decoder.source(encoded).read_header();
+    decoder.decode(decoded);
+    Assert::IsTrue(decoder.statistics().line_count == decoderStatistics.line_count);
+}
+
+
+void TestStatistics()
+{
+    TestStatistics(1, interleave_mode::none);
+    TestStatistics(3, interleave_mode::line);
+    TestStatistics(3, interleave_mode::sample);
+}
+
+
+size_t CountSpans(const vector<trace_span>& spans, const trace_event event)
+{
+    return static_cast<size_t>(std::count_if(spans.cbegin(), spans.cend(), [event](const trace_span& span) { return span.event == event; }));
+}
+
+
+void TestTrace(const interleave_mode interleaveMode)
+{
+    const frame_info info{61, 33, 8, 3};
+    const vector<uint8_t> source = charls_imagegen::generate_image({charls_imagegen::image_family::smooth, info.width, info.height, 8, 3, interleaveMode == interleave_mode::none, 7});
+    const size_t scanCount = interleaveMode == interleave_mode::none ? 3 : 1;
+
+    trace_ring_buffer encoderTrace{1000};
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleaveMode).trace(encoderTrace);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source));
+
+    // The scans of interleave mode none are coded in place (without line transforms) one after another by the same codec.
+    vector<trace_span> spans = encoderTrace.spans();
+    Assert::IsTrue(CountSpans(spans, trace_event::create_codec) == 1);
+    Assert::IsTrue(CountSpans(spans, trace_event::scan) == scanCount);
+    Assert::IsTrue(CountSpans(spans, trace_event::flush) == scanCount);
+    Assert::IsTrue(CountSpans(spans, trace_event::process_line) == (scanCount == 1 ? info.height : 0));
+    vector<uint32_t> scanIndexes;
+    for (const auto& span : spans)
+    {
+        Assert::IsTrue(span.start_time <= span.end_time && span.index < (span.event == trace_event::process_line ? info.height : 1));
+        Assert::IsTrue(span.scan < (span.event == trace_event::scan ? scanCount : 1));
+        if (span.event == trace_event::scan)
+        {
+            scanIndexes.push_back(span.scan);
+        }
+    }
+    std::sort(scanIndexes.begin(), scanIndexes.end());
+    Assert::IsTrue(scanIndexes == (scanCount == 1 ? vector<uint32_t>{0} : vector<uint32_t>{0, 1, 2}));
+
+    trace_ring_buffer decoderTrace{1000};
+    jpegls_decoder decoder;
+    decoder.trace(decoderTrace).source(encoded).read_header();
+    vector<uint8_t> strip(static_cast<size_t>(info.width) * info.component_count * 4);
+    uint32_t decodedRowCount{};
+    auto rowHandler = [&decodedRowCount](const void* /*rows*/, const uint32_t rowCount) { decodedRowCount += rowCount; };
+    decoder.decode_rows(strip.data(), strip.size(), rowHandler);
+
+    Assert::IsTrue(decodedRowCount == scanCount * info.height);
+
+    // Decoding to rows uses the line transforms also for the scans of interleave mode none.
+    spans = decoderTrace.spans();
+    Assert::IsTrue(CountSpans(spans, trace_event::read_header) == 1);
+    Assert::IsTrue(CountSpans(spans, trace_event::create_codec) == 1);
+    Assert::IsTrue(CountSpans(spans, trace_event::scan) == scanCount);
+    Assert::IsTrue(CountSpans(spans, trace_event::process_line) == scanCount * info.height);
+    Assert::IsTrue(CountSpans(spans, trace_event::flush) == 1);
+    Assert::IsTrue(spans.front().event == trace_event::read_header && spans.back().event == trace_event::flush);
+
+    // A full ring buffer keeps the last spans.
+    trace_ring_buffer smallTrace{2};
+    decoder.reset().trace(smallTrace).source(encoded).read_header();
+    decoder.decode_rows(strip.data(), strip.size(), rowHandler);
+    Assert::IsTrue(smallTrace.span_count() == spans.size() - 1); // The codec is reused.
+    Assert::IsTrue(smallTrace.spans().size() == 2 && smallTrace.spans().back().event == trace_event::flush);
+    smallTrace.clear();
+    Assert::IsTrue(smallTrace.spans().empty());
+}
+
+
+void TestTrace()
+{
+    TestTrace(interleave_mode::none);
+    TestTrace(interleave_mode::sample);
+
+    // Restart intervals that are decoded in parallel report a scan span with the index of the interval (and of the scan).
+    // The intervals are divided over the threads: every thread decodes its intervals with one codec.
+    const frame_info info{61, 33, 8, 3};
+    const vector<uint8_t> source = charls_imagegen::generate_image({charls_imagegen::image_family::smooth, info.width, info.height, 8, 3, false, 7});
+    jpegls_encoder encoder;
+    encoder.frame_info(info).interleave_mode(interleave_mode::sample).restart_interval(2);
+    vector<uint8_t> encoded(encoder.estimated_destination_size());
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source));
+
+    trace_ring_buffer decoderTrace{1000};
+    jpegls_decoder decoder;
+    decoder.trace(decoderTrace).parallel_decoding(true).source(encoded).read_header();
+    vector<uint8_t> destination(decoder.destination_size());
+    decoder.decode(destination);
+    Assert::IsTrue(destination == source);
+
+    vector<uint32_t> intervalIndexes;
+    for (const auto& span : decoderTrace.spans())
+    {
+        if (span.event == trace_event::scan)
+        {
+            Assert::IsTrue(span.scan == 0);
+            intervalIndexes.push_back(span.index);
+        }
+    }
+    std::sort(intervalIndexes.begin(), intervalIndexes.end());
+    vector<uint32_t> expectedIndexes(17);
+    std::iota(expectedIndexes.begin(), expectedIndexes.end(), 0U);
+    Assert::IsTrue(intervalIndexes == expectedIndexes);
+
+    // The last interval has 1 line and is decoded with a codec of its own.
+    const size_t threadCount = std::min(size_t{17}, static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1U)));
+    Assert::IsTrue(CountSpans(decoderTrace.spans(), trace_event::create_codec) <= threadCount + 1);
+}
+
+
+// Compares a CPU specific kernel with the generic implementation, for every length and every position of the first different sample.
+template<typename T>
+void TestCountEqualKernel(int32_t (*kernel)(const T*, T, int32_t))
+{
+    constexpr int32_t maximumCount = 160;
+    const auto value = static_cast<T>(0xA5A5);
+    vector<T> samples(maximumCount + 2, value);
+
+    // Offset 1 tests the unaligned loads.
+    for (size_t offset = 0; offset < 2; ++offset)
+    {
+        for (int32_t count = 0; count <= maximumCount; ++count)
+        {
+            for (int32_t different = 0; different <= count; ++different)
+            {
+                samples[offset + static_cast<size_t>(different)] = static_cast<T>(value - 1);
+                Assert::IsTrue(kernel(samples.data() + offset, value, count) == different);
+                Assert::IsTrue(CountEqualPixels(samples.data() + offset, value, count) == different);
+                samples[offset + static_cast<size_t>(different)] = value;
+            }
+        }
+    }
+}
+
+
+// The kernels are internal functions of the library: only a test linked with the static library can call them.
+void TestCpuDispatch()
+{
+    const string path{cpu_dispatch_path()};
+    Assert::IsTrue(path == "generic" || path == "sse2" || path == "avx2" || path == "avx512bw");
+
+#ifdef CHARLS_STATIC
+    const vector<const CodecKernels*> kernels = GetSupportedCodecKernels();
+    Assert::IsTrue(string(kernels.front()->name) == "generic" && path == kernels.back()->name);
+    for (const CodecKernels* kernel : kernels)
+    {
+        TestCountEqualKernel(kernel->countEqual8);
+        TestCountEqualKernel(kernel->countEqual16);
+    }
+#endif
+}
+
+
+// Single component scans are coded in place when the buffer alignment allows it: an unaligned buffer must give the same result.
+void TestInPlaceCoding(uint32_t restartInterval)
+{
+    const frame_info info{77, 41, 16, 1};
+    const vector<uint8_t> noise = MakeSomeNoise(static_cast<size_t>(info.width) * info.height, 10, 21);
+    vector<uint8_t> source(noise.size() * 2 + 1);
+    for (size_t i = 0; i < noise.size(); ++i)
+    {
+        source[1 + i * 2] = noise[i];
+        source[2 + i * 2] = static_cast<uint8_t>(i % 3 == 0 ? 255 : 0);
+    }
+
+    jpegls_encoder encoder;
+    encoder.frame_info(info).restart_interval(restartInterval);
+    vector<uint8_t> encoded(source.size() * 2 + 1024);
+    encoder.destination(encoded);
+    encoded.resize(encoder.encode(source.data() + 1, source.size() - 1));
+
+    vector<uint16_t> aligned(source.size() / 2);
+    jpegls_decoder decoder{encoded};
+    decoder.read_header();
+    decoder.decode(aligned);
+
+    vector<uint8_t> unaligned(source.size());
+    decoder.reset().source(encoded).read_header();
+    decoder.decode(unaligned.data() + 1, unaligned.size() - 1, 0);
+
+    Assert::IsTrue(std::equal(unaligned.cbegin() + 1, unaligned.cend(), source.cbegin() + 1));
+    Assert::IsTrue(memcmp(aligned.data(), source.data() + 1, source.size() - 1) == 0);
+}
+
+
 void TestEncodeFromStream(const char* file, int offset, int width, int height, int bpp, int componentCount, interleave_mode ilv, size_t expectedLength)
 {
     basic_filebuf<char> myFile; // On the stack
@@ -591,9 +1675,47 @@ void UnitTest()
 
         TestDecodeRect();
 
+        cout << "Test Restart interval\n";
+        TestRestartInterval();
+
+        cout << "Test Planar components\n";
+        TestPlanarComponents(0);
+        TestPlanarComponents(16);
+
+        cout << "Test Batch\n";
+        TestBatch();
+
+        cout << "Test Reset\n";
+        TestReset();
+
+        cout << "Test Row callbacks\n";
+        TestRowCallbacks();
+
+        cout << "Test Partial source\n";
+        TestPartialSource();
+
+        cout << "Test Decode region\n";
+        TestDecodeRegion();
+
+        cout << "Test Row index\n";
+        TestRowIndex();
+
+        cout << "Test Preview\n";
+        TestPreview();
+
+        cout << "Test In Place Coding\n";
+        TestInPlaceCoding(0);
+        TestInPlaceCoding(7);
+
         cout << "Test Traits\n";
         TestTraits16bit();
         TestTraits8bit();
+        TestLosslessTraits();
+        TestLosslessRoundTrip();
+        TestSyntheticImages();
+        TestStatistics();
+        TestTrace();
+        TestCpuDispatch();
 
         cout << "Windows bitmap BGR/BGRA output\n";
         TestBgr();
@@ -603,6 +1725,7 @@ void UnitTest()
         TestTooSmallOutputBuffer();
 
         TestFailOnTooSmallOutputBuffer();
+        TestEstimatedDestinationSize();
 
         cout << "Test Color transform equivalence on HP images\n";
         TestColorTransforms_HpImages();
@@ -631,7 +1754,7 @@ int main(const int argc, const char * const argv[])
 {
     if (argc == 1)
     {
-        cout << "CharLS test runner.\nOptions: -unittest, -bitstreamdamage, -performance[:loop-count], -decodeperformance[:loop-count], -decoderaw -encodepnm -decodetopnm -comparepnm\n";
+        cout << "CharLS test runner.\nOptions: -unittest, -bitstreamdamage, -dicom, -decoderaw -encodepnm -decodetopnm -comparepnm\n";
         return EXIT_FAILURE;
     }
 
@@ -699,53 +1822,6 @@ int main(const int argc, const char * const argv[])
             continue;
         }
 
-        if (str.compare(0, 12, "-performance") == 0)
-        {
-            int loopCount = 1;
-
-            // Extract the optional loop count from the command line. Longer running tests make the measurements more reliable.
-            auto index = str.find(':');
-            if (index != string::npos)
-            {
-                loopCount = stoi(str.substr(++index));
-                if (loopCount < 1)
-                {
-                    cout << "Loop count not understood or invalid: %s" << str << "\n";
-                    break;
-                }
-            }
-
-            PerformanceTests(loopCount);
-            continue;
-        }
-
-        if (str.compare(0, 17, "-rgb8_performance") == 0)
-        {
-            // See the comments in function, how to prepare this test.
-            TestLargeImagePerformanceRgb8(1);
-            continue;
-        }
-
-        if (str.compare(0, 18, "-decodeperformance") == 0)
-        {
-            int loopCount = 1;
-
-            // Extract the optional loop count from the command line. Longer running tests make the measurements more reliable.
-            auto index = str.find(':');
-            if (index != string::npos)
-            {
-                loopCount = stoi(str.substr(++index));
-                if (loopCount < 1)
-                {
-                    cout << "Loop count not understood or invalid: " << str << "\n";
-                    break;
-                }
-            }
-
-            DecodePerformanceTests(loopCount);
-            continue;
-        }
-
         if (str == "-dicom")
         {
             TestDicomWG4Images();
@@ -1,8 +0,0 @@
-// Copyright (c) Team CharLS.
-// SPDX-License-Identifier: BSD-3-Clause
-
-#pragma once
-
-void PerformanceTests(int loopCount);
-void DecodePerformanceTests(int loopCount);
-void TestLargeImagePerformanceRgb8(int loopCount);
@@ -0,0 +1,79 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pch.h"
+
+#include "../src/cpu_dispatch.h"
+
+#include <charls/charls.h>
+
+#include <string>
+#include <vector>
+
+using Microsoft::VisualStudio::CppUnitTestFramework::Assert;
+using namespace charls;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Compares a CPU specific kernel with the generic implementation, for every length and every position of the first different sample.
+template<typename T>
+void test_count_equal_kernel(int32_t (*kernel)(const T*, T, int32_t))
+{
+    constexpr int32_t maximum_count = 160;
+    const auto value = static_cast<T>(0xA5A5);
+    vector<T> samples(maximum_count + 2, value);
+
+    // Offset 1 tests the unaligned loads.
+    for (int32_t offset = 0; offset < 2; ++offset)
+    {
+        for (int32_t count = 0; count <= maximum_count; ++count)
+        {
+            for (int32_t different = 0; different <= count; ++different)
+            {
+                samples[offset + different] = static_cast<T>(value - 1);
+                Assert::AreEqual(different, kernel(samples.data() + offset, value, count));
+                Assert::AreEqual(different, CountEqualPixels(samples.data() + offset, value, count));
+                samples[offset + different] = value;
+            }
+        }
+    }
+}
+
+} // namespace
+
+namespace CharLSUnitTest {
+
+// clang-format off
+
+TEST_CLASS(cpu_dispatch_test)
+{
+public:
+    TEST_METHOD(selected_kernels_are_most_specific)
+    {
+        const vector<const CodecKernels*> kernels = GetSupportedCodecKernels();
+
+        Assert::AreEqual(string("generic"), string(kernels.front()->name));
+        Assert::AreEqual(string(kernels.back()->name), string(GetCodecKernels().name));
+        Assert::AreEqual(string(kernels.back()->name), string(cpu_dispatch_path()));
+    }
+
+    TEST_METHOD(count_equal_8)
+    {
+        for (const CodecKernels* kernels : GetSupportedCodecKernels())
+        {
+            test_count_equal_kernel(kernels->countEqual8);
+        }
+    }
+
+    TEST_METHOD(count_equal_16)
+    {
+        for (const CodecKernels* kernels : GetSupportedCodecKernels())
+        {
+            test_count_equal_kernel(kernels->countEqual16);
+        }
+    }
+};
+
+} // namespace CharLSUnitTest
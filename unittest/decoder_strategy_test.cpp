@@ -39,6 +39,21 @@ class DecoderStrategyTester final : public charls::DecoderStrategy
     {
         return ReadLongValue(length);
     }
+
+    int32_t ReadHighBitsForward()
+    {
+        return ReadHighBits();
+    }
+
+    int32_t PeekLeadingOnesForward()
+    {
+        return PeekLeadingOnes();
+    }
+
+    void SkipForward(int32_t length) noexcept
+    {
+        Skip(length);
+    }
 };
 
 } // namespace
@@ -84,6 +99,96 @@ TEST_CLASS(DecoderStrategyTest)
             Assert::AreEqual(inData[i].val, actual);
         }
     }
+
+    TEST_METHOD(ReadHighBits)
+    {
+        // Unary codes shorter and longer than the bit cache of the decoder.
+        const int32_t highBitCounts[] = {0, 1, 7, 15, 16, 17, 31, 55, 63, 64, 65, 100, 3};
+
+        uint8_t encBuf[100];
+        const JlsParameters params{};
+
+        EncoderStrategyTester encoder(params);
+
+        ByteStreamInfo stream{nullptr, encBuf, sizeof(encBuf)};
+        encoder.InitForward(stream);
+
+        for (const int32_t highBitCount : highBitCounts)
+        {
+            for (int32_t i = 0; i < highBitCount; i += 16)
+            {
+                encoder.AppendToBitStreamForward(0, std::min(16, highBitCount - i));
+            }
+            encoder.AppendToBitStreamForward(1, 1);
+        }
+        encoder.AppendToBitStreamForward(0xFFFF, 16);
+        encoder.EndScanForward();
+
+        const auto length = encoder.GetLengthForward();
+        DecoderStrategyTester dec(params, encBuf, length);
+        for (const int32_t highBitCount : highBitCounts)
+        {
+            Assert::AreEqual(highBitCount, dec.ReadHighBitsForward());
+        }
+        Assert::AreEqual(0xFFFF, dec.Read(16));
+    }
+
+    TEST_METHOD(PeekLeadingOnes)
+    {
+        uint8_t encBuf[100];
+        const JlsParameters params{};
+
+        EncoderStrategyTester encoder(params);
+
+        ByteStreamInfo stream{nullptr, encBuf, sizeof(encBuf)};
+        encoder.InitForward(stream);
+
+        encoder.AppendToBitStreamForward(0x7, 3);
+        encoder.AppendToBitStreamForward(0, 1);
+        encoder.AppendToBitStreamForward(0, 1);
+        encoder.AppendToBitStreamForward(0xFFFF, 16);
+        encoder.AppendToBitStreamForward(0xFFFF, 16);
+        encoder.AppendToBitStreamForward(0, 8);
+        encoder.EndScanForward();
+
+        const auto length = encoder.GetLengthForward();
+        DecoderStrategyTester dec(params, encBuf, length);
+
+        Assert::AreEqual(3, dec.PeekLeadingOnesForward());
+        Assert::AreEqual(3, dec.PeekLeadingOnesForward()); // bits are not consumed.
+        dec.SkipForward(4);
+        Assert::AreEqual(0, dec.PeekLeadingOnesForward());
+        dec.SkipForward(1);
+
+        // 32 bits with 0xFF bytes: the ones after the bit stuffing are counted once the cache has been refilled.
+        int32_t onesCount = 0;
+        while (onesCount < 32)
+        {
+            const int32_t count = dec.PeekLeadingOnesForward();
+            Assert::IsTrue(count > 0);
+            dec.SkipForward(count);
+            onesCount += count;
+        }
+        Assert::AreEqual(32, onesCount);
+        Assert::AreEqual(0, dec.PeekLeadingOnesForward());
+    }
+
+    TEST_METHOD(CountLeadingZeros)
+    {
+        // A single bit and all lower bits set, at every position of both 32-bit halves.
+        for (int32_t bit = 0; bit < 64; ++bit)
+        {
+            for (const uint64_t value : {uint64_t{1} << bit, (uint64_t{1} << bit) | ((uint64_t{1} << bit) - 1)})
+            {
+                Assert::AreEqual(63 - bit, charls::CountLeadingZeros(value));
+                Assert::AreEqual(charls::CountLeadingZerosPortable(value), charls::CountLeadingZeros(value));
+                if (bit < 32)
+                {
+                    Assert::AreEqual(31 - bit, charls::CountLeadingZeros(static_cast<uint32_t>(value)));
+                }
+            }
+        }
+    }
 };
 
 }
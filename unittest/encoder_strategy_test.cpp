@@ -77,6 +77,35 @@ TEST_CLASS(EncoderStrategyTest)
         Assert::AreEqual(static_cast<uint8_t>(0xC0), data[12]);
         Assert::AreEqual(static_cast<uint8_t>(0x77), data[13]);
     }
+
+    TEST_METHOD(AppendToBitStreamWithoutFFPattern)
+    {
+        JlsParameters params;
+
+        EncoderStrategyTester strategy(params);
+
+        uint8_t data[1024];
+
+        ByteStreamInfo stream;
+        stream.rawStream = nullptr;
+        stream.rawData = data;
+        stream.count = sizeof(data);
+        strategy.InitForward(stream);
+
+        // Bit counts that are not a multiple of 8 to flush complete bytes while bits are pending.
+        for (int i = 0; i < 16; ++i)
+        {
+            strategy.AppendToBitStreamForward(0xAAAAA, 20);
+        }
+
+        strategy.FlushForward();
+
+        Assert::AreEqual(static_cast<size_t>(40), strategy.GetLengthForward());
+        for (size_t i = 0; i < 40; ++i)
+        {
+            Assert::AreEqual(static_cast<uint8_t>(0xAA), data[i]);
+        }
+    }
 };
 
 }
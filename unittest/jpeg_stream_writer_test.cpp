@@ -312,6 +312,23 @@ TEST_CLASS(JpegStreamWriterTest)
         Assert::AreEqual(static_cast<uint8_t>(7), buffer[14]);
     }
 
+    TEST_METHOD(WriteDefineRestartIntervalSegment)
+    {
+        array<uint8_t, 6> buffer{};
+        const ByteStreamInfo info = FromByteArray(buffer.data(), buffer.size());
+        JpegStreamWriter writer(info);
+
+        writer.WriteDefineRestartIntervalSegment(0x1234);
+
+        Assert::AreEqual(buffer.size(), writer.GetBytesWritten());
+        Assert::AreEqual(static_cast<uint8_t>(0xFF), buffer[0]);
+        Assert::AreEqual(static_cast<uint8_t>(JpegMarkerCode::DefineRestartInterval), buffer[1]);
+        Assert::AreEqual(static_cast<uint8_t>(0), buffer[2]);
+        Assert::AreEqual(static_cast<uint8_t>(4), buffer[3]);
+        Assert::AreEqual(static_cast<uint8_t>(0x12), buffer[4]);
+        Assert::AreEqual(static_cast<uint8_t>(0x34), buffer[5]);
+    }
+
     TEST_METHOD(WriteStartOfScanMarker)
     {
         array<uint8_t, 10> buffer{};
@@ -0,0 +1,100 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pch.h"
+
+#include "util.h"
+
+#include <charls/charls.h>
+
+#include <vector>
+
+using Microsoft::VisualStudio::CppUnitTestFramework::Assert;
+using namespace charls;
+using std::vector;
+
+namespace CharLSUnitTest {
+
+// clang-format off
+
+TEST_CLASS(jpegls_batch_test)
+{
+public:
+    TEST_METHOD(create_destroy)
+    {
+        // ReSharper disable once CppLocalVariableWithNonTrivialDtorIsNeverUsed
+        jpegls_batch batch;
+    }
+
+    TEST_METHOD(create_and_move)
+    {
+        jpegls_batch batch1(2);
+        jpegls_batch batch2(std::move(batch1));
+
+        jpegls_batch batch3(1);
+        batch3 = std::move(batch2);
+    }
+
+    TEST_METHOD(encode_empty_batch)
+    {
+        const jpegls_batch batch(2);
+        batch.encode(nullptr, 0);
+        batch.decode(nullptr, 0);
+    }
+
+    TEST_METHOD(encode_with_null_frames)
+    {
+        const jpegls_batch batch(2);
+
+        assert_expect_exception(jpegls_errc::invalid_argument, [&] { batch.encode(nullptr, 1); });
+        assert_expect_exception(jpegls_errc::invalid_argument, [&] { batch.decode(nullptr, 1); });
+    }
+
+    TEST_METHOD(encode_and_decode)
+    {
+        constexpr size_t frame_count{10};
+        const vector<uint8_t> source{0, 1, 2, 3, 4, 5};
+        const frame_info frame_info{3, 2, 8, 1};
+
+        vector<vector<uint8_t>> encoded(frame_count, vector<uint8_t>(1024));
+        vector<batch_encode_frame> encode_frames(frame_count);
+        for (size_t i = 0; i < frame_count; ++i)
+        {
+            encode_frames[i] = {source.data(), source.size(), 0, frame_info, interleave_mode::none, 0, encoded[i].data(), encoded[i].size(), 0, jpegls_errc::unexpected_failure};
+        }
+
+        const jpegls_batch batch(3);
+        batch.encode(encode_frames);
+
+        vector<vector<uint8_t>> decoded(frame_count, vector<uint8_t>(source.size()));
+        vector<batch_decode_frame> decode_frames(frame_count);
+        for (size_t i = 0; i < frame_count; ++i)
+        {
+            Assert::IsTrue(encode_frames[i].result == jpegls_errc::success);
+            decode_frames[i] = {encoded[i].data(), encode_frames[i].bytes_written, decoded[i].data(), decoded[i].size(), 0, jpegls_errc::unexpected_failure};
+        }
+
+        batch.decode(decode_frames);
+
+        for (size_t i = 0; i < frame_count; ++i)
+        {
+            Assert::IsTrue(decode_frames[i].result == jpegls_errc::success);
+            Assert::IsTrue(decoded[i] == source);
+        }
+    }
+
+    TEST_METHOD(decode_bad_frame_reports_error_per_frame)
+    {
+        const vector<uint8_t> source{0x33, 0x33};
+        vector<uint8_t> destination(100);
+
+        vector<batch_decode_frame> frames{{source.data(), source.size(), destination.data(), destination.size(), 0, jpegls_errc::success}};
+
+        const jpegls_batch batch(1);
+        batch.decode(frames);
+
+        Assert::IsTrue(frames[0].result == jpegls_errc::jpeg_marker_start_byte_not_found);
+    }
+};
+
+} // namespace CharLSUnitTest
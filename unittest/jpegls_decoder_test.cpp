@@ -321,6 +321,29 @@ TEST_CLASS(jpegls_decoder_test)
         Assert::AreEqual(expected_size, decoded_destination.size());
     }
 
+    TEST_METHOD(decode_twice_with_reset)
+    {
+        const vector<uint8_t> encoded_source{read_file("DataFiles/T8C0E0.JLS")};
+
+        jpegls_decoder decoder{encoded_source};
+        decoder.read_header();
+        const auto destination1{decoder.decode<vector<uint8_t>>()};
+
+        decoder.reset().source(encoded_source).read_header();
+        const auto destination2{decoder.decode<vector<uint8_t>>()};
+
+        Assert::IsTrue(destination1 == destination2);
+    }
+
+    TEST_METHOD(source_without_reset_throws)
+    {
+        const vector<uint8_t> encoded_source{read_file("DataFiles/T8C0E0.JLS")};
+
+        jpegls_decoder decoder{encoded_source};
+
+        assert_expect_exception(jpegls_errc::invalid_operation, [&] { decoder.source(encoded_source); });
+    }
+
     TEST_METHOD(simple_decode_to_uint16_buffer)
     {
         const vector<uint8_t> encoded_source{read_file("DataFiles/T8C0E0.JLS")};
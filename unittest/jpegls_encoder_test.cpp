@@ -116,6 +116,21 @@ TEST_CLASS(jpegls_encoder_test)
         assert_expect_exception(jpegls_errc::invalid_argument_near_lossless, [&] { encoder.near_lossless(256); });
     }
 
+    TEST_METHOD(restart_interval)
+    {
+        jpegls_encoder encoder;
+
+        encoder.restart_interval(0); // set lowest value.
+        encoder.restart_interval(65535); // set highest value.
+    }
+
+    TEST_METHOD(restart_interval_bad)
+    {
+        jpegls_encoder encoder;
+
+        assert_expect_exception(jpegls_errc::invalid_argument, [&] { encoder.restart_interval(65536); });
+    }
+
     TEST_METHOD(estimated_destination_size_minimal_frame_info)
     {
         jpegls_encoder encoder;
@@ -519,6 +534,57 @@ TEST_CLASS(jpegls_encoder_test)
         test_by_decoding(encoded, frame_info, source.data(), source.size(), interleave_mode::none);
     }
 
+    TEST_METHOD(encode_with_restart_interval)
+    {
+        const vector<uint8_t> source{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+        const frame_info frame_info{2, 6, 8, 1};
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info).restart_interval(2);
+
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+
+        const size_t bytes_written{encoder.encode(source)};
+        destination.resize(bytes_written);
+
+        test_by_decoding(destination, frame_info, source.data(), source.size(), interleave_mode::none);
+    }
+
+    TEST_METHOD(encode_twice_with_reset)
+    {
+        const vector<uint8_t> source{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+        const frame_info frame_info{4, 3, 8, 1};
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info);
+
+        vector<uint8_t> destination1(encoder.estimated_destination_size());
+        encoder.destination(destination1);
+        destination1.resize(encoder.encode(source));
+
+        vector<uint8_t> destination2(encoder.estimated_destination_size());
+        encoder.reset().destination(destination2);
+        destination2.resize(encoder.encode(source));
+
+        Assert::IsTrue(destination1 == destination2);
+        test_by_decoding(destination2, frame_info, source.data(), source.size(), interleave_mode::none);
+    }
+
+    TEST_METHOD(destination_without_reset_throws)
+    {
+        const vector<uint8_t> source{0, 1, 2, 3, 4, 5};
+
+        jpegls_encoder encoder;
+        encoder.frame_info({3, 2, 8, 1});
+
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        static_cast<void>(encoder.encode(source));
+
+        assert_expect_exception(jpegls_errc::invalid_operation, [&] { encoder.destination(destination); });
+    }
+
 private:
     static void test_by_decoding(const vector<uint8_t>& encoded_source, const frame_info& source_frame_info, const uint8_t* source, const size_t source_size, const charls::interleave_mode interleave_mode)
     {